@@ -0,0 +1,189 @@
+/*
+ * Copyright © 1990 The Portland State University OCCAM Project Team
+ * [This program is licensed under the GPL version 3 or later.]
+ * Please see the file LICENSE in the source
+ * distribution of this software for license terms.
+ */
+
+#include "DenseTable.h"
+#include "Key.h"
+#include "Relation.h"
+#include "Table.h"
+#include "VariableList.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+DenseTable::DenseTable(VariableList *vars)
+{
+    int count = vars->getVarCount();
+    int indices[count];
+    for (int i = 0; i < count; i++) {
+        indices[i] = i;
+    }
+    init(vars, indices, count);
+    full = true;
+}
+
+
+DenseTable::DenseTable(VariableList *vars, Relation *rel)
+{
+    int count = rel->getVariableCount();
+    int indices[count];
+    rel->copyVariables(indices, count);
+    Relation::sort(indices, count);
+    init(vars, indices, count);
+    full = (count == vars->getVarCount());
+}
+
+
+void DenseTable::init(VariableList *vars, int *indices, int count)
+{
+    varList = vars;
+    varCount = count;
+    keysize = vars->getKeySize();
+    varIndices = new int[varCount];
+    strides = new long long[varCount];
+    cards = new int[varCount];
+    stateCount = 1;
+    for (int i = varCount - 1; i >= 0; i--) {
+        varIndices[i] = indices[i];
+        cards[i] = vars->getVariable(indices[i])->cardinality;
+        strides[i] = stateCount;
+        stateCount *= cards[i];
+    }
+    values = new double[stateCount];
+    clear();
+}
+
+
+DenseTable::~DenseTable()
+{
+    delete [] varIndices;
+    delete [] strides;
+    delete [] cards;
+    delete [] values;
+}
+
+
+bool DenseTable::fits(VariableList *vars, double maxStates)
+{
+    double states = 1;
+    for (int i = 0; i < vars->getVarCount(); i++) {
+        states *= vars->getVariable(i)->cardinality;
+        if (states > maxStates) return false;
+    }
+    return true;
+}
+
+
+void DenseTable::clear()
+{
+    memset(values, 0, stateCount * sizeof(double));
+}
+
+
+long long DenseTable::stateOf(KeySegment *key)
+{
+    long long state = 0;
+    for (int i = 0; i < varCount; i++) {
+        state += Key::getKeyValue(key, keysize, varList, varIndices[i]) * strides[i];
+    }
+    return state;
+}
+
+
+void DenseTable::keyOf(long long state, KeySegment *key)
+{
+    int digits[varCount];
+    for (int i = 0; i < varCount; i++) {
+        digits[i] = (int) ((state / strides[i]) % cards[i]);
+    }
+    if (full)
+        Key::buildFullKey(key, keysize, varList, digits);
+    else
+        Key::buildKey(key, keysize, varList, varIndices, digits, varCount);
+}
+
+
+void DenseTable::addTable(Table *table)
+{
+    long long count = table->getTupleCount();
+    for (long long i = 0; i < count; i++) {
+        values[stateOf(table->getKey(i))] += table->getValue(i);
+    }
+}
+
+
+void DenseTable::toTable(Table *table, double minValue)
+{
+    KeySegment key[keysize];
+    table->reset(keysize);
+    for (long long s = 0; s < stateCount; s++) {
+        if (values[s] > minValue) {
+            keyOf(s, key);
+            table->addTuple(key, values[s]);
+        }
+    }
+}
+
+
+int DenseTable::positionOf(int var)
+{
+    for (int i = 0; i < varCount; i++) {
+        if (varIndices[i] == var) return i;
+    }
+    return -1;
+}
+
+
+long long DenseTable::cellOf(Relation *rel, KeySegment *key)
+{
+    long long cell = 0;
+    int count = rel->getVariableCount();
+    for (int i = 0; i < count; i++) {
+        int var = rel->getVariable(i);
+        cell = cell * varList->getVariable(var)->cardinality + Key::getKeyValue(key, keysize, varList, var);
+    }
+    return cell;
+}
+
+
+/**
+ * makeCellMap - the states are walked in order with an odometer over the variable values,
+ * so each step only adjusts the cell number for the digits that changed.
+ */
+unsigned int *DenseTable::makeCellMap(Relation *rel, long long *cellCount)
+{
+    //-- weight of each variable within the relation's cell number (0 if not in the relation)
+    long long weight[varCount];
+    memset(weight, 0, sizeof(weight));
+    long long cells = 1;
+    for (int i = rel->getVariableCount() - 1; i >= 0; i--) {
+        int pos = positionOf(rel->getVariable(i));
+        if (pos < 0)
+            return NULL;
+        weight[pos] = cells;
+        cells *= cards[pos];
+    }
+    *cellCount = cells;
+
+    unsigned int *map = new unsigned int[stateCount];
+    int digits[varCount];
+    memset(digits, 0, sizeof(digits));
+    long long cell = 0;
+    for (long long s = 0; s < stateCount; s++) {
+        map[s] = (unsigned int) cell;
+        for (int i = varCount - 1; i >= 0; i--) {
+            if (++digits[i] < cards[i]) {
+                cell += weight[i];
+                break;
+            }
+            digits[i] = 0;
+            cell -= (long long) (cards[i] - 1) * weight[i];
+        }
+    }
+    return map;
+}
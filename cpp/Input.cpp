@@ -9,11 +9,24 @@
 #include "Input.h"
 #include "Key.h"
 #include "Options.h"
+#include "Parallel.h"
 #include "VariableList.h"
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
 #include <stdlib.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <queue>
+#include <unordered_map>
+#include <vector>
 
 struct LostVar {
         int num;
@@ -45,120 +58,504 @@ bool KeepVal(LostVar *lostvarpt, char * var) {
     return false;
 }
 
-/*ReadData - read data tuples, one per line; return number of lines read
+enum LineStatus { LINE_OK, LINE_SHORT, LINE_OVERFLOW };
+
+/*
+ * parseDataLine - parse the variable values and the tuple value of one data line into
+ * values and indices (one entry per variable in use). valueIndex(j, column, text) gives
+ * the value index of text for variable j, which is in the given data file column, or -1
+ * if the variable has no room for another value; ruleIndex(j, column, rule) does the same
+ * for the new value of one of the variable's rebinning rules. If parsing stops early,
+ * *failVar and *failColumn say where. *keep is false if rebinning or exclusion discards
+ * the line.
+ */
+template <typename F, typename G>
+static LineStatus parseDataLine(char *line, VariableList *vars, LostVar *lostvarp, F valueIndex, G ruleIndex,
+        int *values, int *indices, int *failVar, int *failColumn, double *tupleValue, bool *keep) {
+    char *cp = line;
+    int varCountDF = vars->getVarCountDF(); //Anjali
+    LostVar *lostvarpt;
+    char var[MAXLINE];
+    int j = 0;
+    int value;
+    *keep = true;
+    for (int i = 0; i < varCountDF; i++) { //Anjali
+        if (vars->isVarInUse(i)) { //Anjali
+            *failVar = j;
+            *failColumn = i;
+            if ((vars->getVariable(j)->rebin == true) || (vars->getVariable(j)->exclude != NULL)) {
+                int rule = vars->getRebinRule(j, cp);
+                if (rule != DISCARD) {
+                    value = rule == REBIN_KEEP ? valueIndex(j, i, cp) : ruleIndex(j, i, rule);
+                    if (value < 0) // cardinality error
+                        return LINE_OVERFLOW;
+                    values[j] = value;
+                    indices[j] = j;
+                } else
+                    *keep = false;
+            } else {
+                if (cp[0] == '\0')
+                    return LINE_SHORT;
+                value = valueIndex(j, i, cp);
+                if (value < 0) // cardinality error
+                    return LINE_OVERFLOW;
+                values[j] = value;
+                indices[j] = j;
+            }
+            while (*cp && !(isspace(*cp) || (*cp == ',')))
+                cp++;
+            while (*cp && (isspace(*cp) || (*cp == ',')))
+                cp++; // now at next value
+            j++;
+        } else { //Anjali
+            // check if it is in LostVar list, if yes then if all its values are valid then this row of table can go
+            // otherwise mark it for being removed from building a key
+            if (lostvarp != NULL) {
+                if (isLostVar(i, &lostvarpt, lostvarp)) {
+                    int ret = sscanf(cp, "%[^\t, ]", var);
+                    if (ret == 1) {
+                        if (!KeepVal(lostvarpt, var))
+                            *keep = false;
+                    } else {
+                        printf("something went wrong");
+                        exit(1);
+                    }
+                }
+            }
+            while (*cp && !(isspace(*cp) || (*cp == ',')))
+                cp++;
+            while (*cp && (isspace(*cp) || (*cp == ',')))
+                cp++; // now at next value
+        } //Anjali
+    }
+    while (*cp && (isspace(*cp) || (*cp == ',')))
+        cp++;
+    if (*cp) { // there is still a tuple value on the line
+        *tupleValue = (double) strtod(cp, (char **) NULL);
+    } else {
+        *tupleValue = 1;
+    }
+    return LINE_OK;
+}
+
+static void reportShortLine(int lineno, const char *line) {
+    printf("ERROR: Expected additional input, but line ended prematurely\n");
+    printf("Line number: %d\n", lineno);
+    printf("Line so far: %s\n", line);
+    exit(1);
+}
+
+static void reportOverflow(VariableList *vars, int lineno, int column, int j, const char *line) {
+    printf("Error in data, line %d: new value exceeds cardinality of variable #%d, \"%s\"\n",
+            lineno, column + 1, vars->getVariable(j)->abbrev);
+    int cardinality = vars->getVariable(j)->cardinality;
+    printf("Cardinality should be %d. ", cardinality);
+    printf("Previously seen values: ");
+    for (int k = 0; k < cardinality; ++k) {
+        printf("%s ", vars->getVariable(j)->valmap[k]);
+    }
+    printf("\nData line: %s\n", line);
+    exit(1);
+}
+
+/*
+ * Parallel reading. The rest of the file is mapped, and split into one chunk per thread
+ * at line ends. Each chunk is parsed into its own table, with value indices from its own
+ * value maps and lines numbered from the start of the chunk. The chunks are then taken in
+ * file order: their new values are added to the variables' value maps in order of first
+ * appearance, which gives each value the index a serial read would, and their tuples are
+ * re-keyed and appended. Errors are held until then, so the one reported is the first in
+ * the file, with the same message and line number as a serial read gives.
+ */
+struct ChunkValue {
+    std::string text;
+    int line; // line of the chunk where the value first appears
+    int column; // data file column of the variable
+    const char *lineStart; // where reading of that line began
+};
+
+struct DataChunk {
+    const char *begin, *end;
+    Table *table; // tuples keyed by the chunk's own value indices, sorted and merged
+    std::vector<std::vector<ChunkValue> > values; // for each variable, its values in order of first appearance
+    long lines; // data lines parsed
+    int lineCount; // lines read (as numbered for messages)
+    LineStatus status; // LINE_OK, or the error parsing stopped at
+    int errorLine;
+    const char *errorStart;
+    const char *stopStart, *stop; // the directive line which ends the data, if it is in this chunk
+};
+
+static const int MIN_CHUNK_BYTES = 1 << 20;
+
+//-- re-read the line beginning at start, as the line reader gives it
+static void chunkLine(const char *start, const char *end, char *line) {
+    int lineno = 0;
+    Options::getLine(&start, end, line, &lineno);
+}
+
+static void parseChunk(DataChunk *chunk, bool first, VariableList *vars, LostVar *lostvarp) {
+    int keysize = vars->getKeySize();
+    int varCount = vars->getVarCount();
+    char line[MAXLINE + 1];
+    char myvalue[101];
+    KeySegment *key = new KeySegment[keysize];
+    int *values = new int[varCount];
+    int *indices = new int[varCount];
+    std::vector<std::unordered_map<std::string, int> > seen(varCount);
+    chunk->values.resize(varCount);
+    int lineno = 0;
+    const char *pos = chunk->begin;
+    const char *lineStart = pos;
+
+    //-- the same value text as VariableList::getVarValueIndex extracts
+    auto valueIndex = [&](int j, int column, const char *value) {
+        int chr;
+        for (chr = 0; chr < 100; chr++) {
+            if (value[chr] == '\0' || isspace(value[chr]) || (value[chr] == ','))
+                break;
+            myvalue[chr] = value[chr];
+        }
+        myvalue[chr] = '\0';
+        std::string text(myvalue, chr);
+        auto found = seen[j].find(text);
+        if (found != seen[j].end())
+            return found->second;
+        int index = chunk->values[j].size();
+        seen[j][text] = index;
+        ChunkValue entry = { text, lineno, column, lineStart };
+        chunk->values[j].push_back(entry);
+        //-- past the cardinality here means the whole file is past it; stop
+        return index < vars->getVariable(j)->cardinality ? index : -1;
+    };
+    auto ruleIndex = [&](int j, int column, int rule) {
+        return valueIndex(j, column, vars->getRebinValue(j, rule));
+    };
+
+    bool gotLine = Options::getLine(&pos, chunk->end, line, &lineno);
+    bool firstLine = first;
+    while (gotLine) {
+        if (!firstLine && line[0] == ':') {
+            chunk->stopStart = lineStart;
+            chunk->stop = pos;
+            break;
+        }
+        firstLine = false;
+        chunk->lines++;
+        double tupleValue;
+        bool keep;
+        int failVar, failColumn;
+        LineStatus status = parseDataLine(line, vars, lostvarp, valueIndex, ruleIndex, values, indices, &failVar,
+                &failColumn, &tupleValue, &keep);
+        if (status != LINE_OK) {
+            chunk->status = status;
+            chunk->errorLine = lineno;
+            chunk->errorStart = lineStart;
+            break;
+        }
+        if (keep) {
+            Key::buildKey(key, keysize, vars, indices, values, varCount);
+            chunk->table->addTuple(key, tupleValue);
+        }
+        lineStart = pos;
+        gotLine = Options::getLine(&pos, chunk->end, line, &lineno);
+    }
+    chunk->lineCount = lineno;
+    chunk->table->sortAndMerge();
+    delete[] indices;
+    delete[] values;
+    delete[] key;
+}
+
+/*
+ * ocReadDataParallel - read data tuples as ocReadData does, with the given number of
+ * threads. Returns -1, having read nothing, if the file can't be mapped.
+ */
+static long ocReadDataParallel(FILE *fin, VariableList *vars, Table *indata, LostVar *lostvarp, int threads) {
+    struct stat st;
+    long offset = ftell(fin);
+    if (offset < 0 || fstat(fileno(fin), &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= offset)
+        return -1;
+    size_t length = st.st_size;
+    char *base = (char*) mmap(NULL, length, PROT_READ, MAP_PRIVATE, fileno(fin), 0);
+    if (base == MAP_FAILED)
+        return -1;
+    madvise(base, length, MADV_SEQUENTIAL);
+    const char *start = base + offset;
+    const char *end = base + length;
+
+    //-- chunks begin just after a line end, so each holds whole lines
+    long long bytes = end - start;
+    if (threads > bytes / MIN_CHUNK_BYTES)
+        threads = bytes / MIN_CHUNK_BYTES > 1 ? (int) (bytes / MIN_CHUNK_BYTES) : 1;
+    std::vector<DataChunk> chunks(threads);
+    const char *next = start;
+    for (int t = 0; t < threads; t++) {
+        DataChunk &chunk = chunks[t];
+        chunk.begin = next;
+        const char *cut = t == threads - 1 ? end : start + bytes * (t + 1) / threads;
+        if (cut < next)
+            cut = next;
+        while (cut < end && cut[-1] != '\n' && cut[-1] != '\r')
+            cut++;
+        chunk.end = next = cut;
+        chunk.table = new Table(vars->getKeySize(), 1024);
+        chunk.lines = 0;
+        chunk.lineCount = 0;
+        chunk.status = LINE_OK;
+        chunk.stopStart = chunk.stop = NULL;
+    }
+    parallelFor(threads, threads, [&](long long begin, long long finish, int thread) {
+        for (long long c = begin; c < finish; c++)
+            parseChunk(&chunks[c], c == 0, vars, lostvarp);
+    });
+
+    int keysize = vars->getKeySize();
+    int varCount = vars->getVarCount();
+    KeySegment *key = new KeySegment[keysize];
+    int *values = new int[varCount];
+    int *indices = new int[varCount];
+    char line[MAXLINE + 1];
+    long lines = 0;
+    int lineOffset = 0;
+    const char *stop = NULL;
+    for (int t = 0; t < threads; t++) {
+        DataChunk &chunk = chunks[t];
+        //-- add the chunk's values to the value maps, noting the first one which doesn't fit
+        std::vector<std::vector<int> > remap(varCount);
+        const ChunkValue *overflow = NULL;
+        int overflowVar = -1;
+        for (int j = 0; j < varCount; j++) {
+            for (size_t k = 0; k < chunk.values[j].size(); k++) {
+                const ChunkValue &value = chunk.values[j][k];
+                int index = vars->getVarValueIndex(j, value.text.c_str());
+                if (index < 0) {
+                    if (overflow == NULL || value.line < overflow->line
+                            || (value.line == overflow->line && value.column < overflow->column)) {
+                        overflow = &value;
+                        overflowVar = j;
+                    }
+                    break;
+                }
+                remap[j].push_back(index);
+            }
+        }
+        if (overflow && (chunk.status != LINE_SHORT || overflow->line <= chunk.errorLine)) {
+            chunkLine(overflow->lineStart, chunk.end, line);
+            reportOverflow(vars, lineOffset + overflow->line, overflow->column, overflowVar, line);
+        }
+        if (chunk.status == LINE_SHORT) {
+            chunkLine(chunk.errorStart, chunk.end, line);
+            reportShortLine(lineOffset + chunk.errorLine, line);
+        }
+
+        //-- re-key the chunk's tuples with the final value indices
+        Table *table = chunk.table;
+        for (long long i = 0; i < table->getTupleCount(); i++) {
+            KeySegment *chunkKey = table->getKey(i);
+            for (int j = 0; j < varCount; j++) {
+                values[j] = remap[j][Key::getKeyValue(chunkKey, keysize, vars, j)];
+                indices[j] = j;
+            }
+            Key::buildKey(key, keysize, vars, indices, values, varCount);
+            //-- duplicates are merged by the caller's sortAndMerge()
+            indata->addTuple(key, table->getValue(i));
+        }
+        lines += chunk.lines;
+        lineOffset += chunk.lineCount;
+        if (chunk.stop) {
+            chunkLine(chunk.stopStart, chunk.end, line);
+            if (strcmp(line, ":test") != 0)
+                printf("Unrecognized directive here: %s\n", line);
+            stop = chunk.stop;
+            break;
+        }
+    }
+    for (int t = 0; t < threads; t++)
+        delete chunks[t].table;
+
+    //-- leave the file where a serial read would: after the directive, or at the end
+    if (stop) {
+        fseek(fin, stop - base, SEEK_SET);
+    } else {
+        fseek(fin, 0, SEEK_END);
+        fgetc(fin);
+    }
+    munmap(base, length);
+    delete[] indices;
+    delete[] values;
+    delete[] key;
+    if (lines == 0 && stop == NULL)
+        printf("No data\n");
+    return lines;
+}
+
+/*
+ * TupleSpill - sums data tuples into a table in hash-indexed mode, so repeated keys take
+ * no more memory, holding at most as many tuples as fit in the memory limit. When the
+ * table is full its tuples are sorted and written to a temporary file as a run, and the
+ * table starts again; finish() merges the runs back into the table. Only the distinct
+ * tuples of the whole input need fit in memory, and only at the end. add() and finish()
+ * return false if a run can't be written.
+ */
+class TupleSpill {
+    public:
+        TupleSpill(Table *table, long long limit);
+        ~TupleSpill();
+        bool add(KeySegment *key, double value);
+        bool finish();
+    private:
+        bool spill();
+        bool readTuple(int run, KeySegment *key, double *value);
+        Table *table;
+        int keysize;
+        long long maxTuples;
+        std::vector<FILE*> runs;
+};
+
+TupleSpill::TupleSpill(Table *table, long long limit) {
+    this->table = table;
+    keysize = table->getKeySize();
+    //-- tuple storage may be up to twice the tuples (it grows by doubling), and the hash
+    //-- slots up to four times
+    long long tupleBytes = 2 * (keysize * sizeof(KeySegment) + sizeof(ocTupleValue)) + 4 * sizeof(long long);
+    maxTuples = limit / tupleBytes;
+    if (maxTuples < 1)
+        maxTuples = 1;
+    table->beginHashed();
+}
+
+TupleSpill::~TupleSpill() {
+    for (size_t r = 0; r < runs.size(); r++)
+        fclose(runs[r]);
+}
+
+bool TupleSpill::add(KeySegment *key, double value) {
+    table->sumTuple(key, value);
+    if (table->getTupleCount() >= maxTuples) {
+        if (!spill())
+            return false;
+        table->beginHashed();
+    }
+    return true;
+}
+
+bool TupleSpill::spill() {
+    table->finalize();
+    FILE *run = tmpfile();
+    if (run == NULL)
+        return false;
+    runs.push_back(run);
+    for (long long i = 0; i < table->getTupleCount(); i++) {
+        double value = table->getValue(i);
+        if (fwrite(table->getKey(i), sizeof(KeySegment), keysize, run) != (size_t) keysize
+                || fwrite(&value, sizeof(value), 1, run) != 1)
+            return false;
+    }
+    if (fflush(run) != 0)
+        return false;
+    rewind(run);
+    table->reset(keysize);
+    return true;
+}
+
+bool TupleSpill::readTuple(int run, KeySegment *key, double *value) {
+    return fread(key, sizeof(KeySegment), keysize, runs[run]) == (size_t) keysize
+            && fread(value, sizeof(*value), 1, runs[run]) == 1;
+}
+
+bool TupleSpill::finish() {
+    if (runs.empty()) {
+        table->finalize();
+        return true;
+    }
+    if (table->getTupleCount() > 0) {
+        if (!spill())
+            return false;
+    } else
+        table->reset(keysize);
+    //-- merge the runs, taking the lowest key from the head of each
+    int runCount = runs.size();
+    KeySegment *keys = new KeySegment[runCount * keysize];
+    std::vector<double> values(runCount);
+    auto later = [&](int a, int b) {
+        return Key::compareKeys(keys + a * keysize, keys + b * keysize, keysize) > 0;
+    };
+    std::priority_queue<int, std::vector<int>, decltype(later)> heads(later);
+    for (int r = 0; r < runCount; r++) {
+        if (readTuple(r, keys + r * keysize, &values[r]))
+            heads.push(r);
+    }
+    while (!heads.empty()) {
+        int r = heads.top();
+        heads.pop();
+        KeySegment *key = keys + r * keysize;
+        long long last = table->getTupleCount() - 1;
+        if (last >= 0 && Key::compareKeys(table->getKey(last), key, keysize) == 0)
+            table->setValue(last, table->getValue(last) + values[r]);
+        else
+            table->addTuple(key, values[r]);
+        if (readTuple(r, key, &values[r]))
+            heads.push(r);
+    }
+    delete[] keys;
+    return true;
+}
+
+/*ReadData - read data tuples, one per line; return number of lines read, or -1 if the
+ * data couldn't be spilled. With more than one thread, files which can be mapped are read
+ * in parallel. With a memory limit (in bytes), the data are read serially and summed as
+ * they are read (see TupleSpill).
  */
-long ocReadData(FILE *fin, VariableList *vars, Table *indata, LostVar *lostvarp) {
+long ocReadData(FILE *fin, VariableList *vars, Table *indata, LostVar *lostvarp, int threads,
+        long long memoryLimit) {
+    if (threads > 1 && memoryLimit <= 0) {
+        long lines = ocReadDataParallel(fin, vars, indata, lostvarp, threads);
+        if (lines >= 0)
+            return lines;
+    }
     char line[MAXLINE];
-    KeySegment *key = 0;
     int lineno = 0;
     double tupleValue;
-    LostVar *lostvarpt;
+    bool keep;
+    int failVar, failColumn;
     int keysize = vars->getKeySize();
-    key = new KeySegment[keysize];
-    int varCountDF = vars->getVarCountDF(); //Anjali
+    KeySegment *key = new KeySegment[keysize];
     int varCount = vars->getVarCount();
-    int *values, *indices;
-    bool gotLine = false;
-    int b_lostvar = 0;
-    int flag = KEEP;
-    char var[MAXLINE];
-    char newvalue[MAXLINE];
-    bool keepval = true;
-    values = new int[varCount];
-    indices = new int[varCount];
-    int j = 0;
-    int value = 0;
+    int *values = new int[varCount];
+    int *indices = new int[varCount];
     int l = 0;
-    gotLine = Options::getLine(fin, line, &lineno);
+    auto valueIndex = [&](int j, int column, const char *value) {
+        return vars->getVarValueIndex(j, value);
+    };
+    auto ruleIndex = [&](int j, int column, int rule) {
+        return vars->getRebinValueIndex(j, rule);
+    };
+    bool gotLine = Options::getLine(fin, line, &lineno);
     if (!gotLine) {
         printf("No data\n");
         return false;
     }
+    TupleSpill *spill = memoryLimit > 0 ? new TupleSpill(indata, memoryLimit) : NULL;
     while (gotLine) {
-        char *cp = line;
         l++;
-        for (int i = 0; i < varCountDF; i++) { //Anjali
-            newvalue[0] = '\0';
-
-            auto checkValue = [&](int resolvedvalue) {
-                if (resolvedvalue < 0) { // cardinality error
-                        printf("Error in data, line %d: new value exceeds cardinality of variable #%d, \"%s\"\n",
-                                lineno, i+1, vars->getVariable(j)->abbrev);
-                        int cardinality = vars->getVariable(j)->cardinality;
-                        printf("Cardinality should be %d. ", cardinality);
-                        printf("Previously seen values: ");
-                        for (int k = 0; k < cardinality; ++k) {
-                            printf("%s ", vars->getVariable(j)->valmap[k]);
-                        }
-                        printf("\nData line: %s\n", line);
-                        exit(1);
-                    } else {
-                        values[j] = resolvedvalue;
-                        indices[j] = j;
-                    }
-            };
-
-            if (vars->isVarInUse(i)) { //Anjali
-                if ((vars->getVariable(j)->rebin == true) || (vars->getVariable(j)->exclude != NULL)) {
-                    vars->getNewValue(j, cp, newvalue);
-                    if (newvalue[0] != '\0') {
-                        value = vars->getVarValueIndex(j, newvalue);
-                        checkValue(value);
-                    } else
-                        flag = DISCARD;
-                } else {
-                    if (cp[0] == '\0') {
-
-                        printf("ERROR: Expected additional input, but line ended prematurely\n");
-                        printf("Line number: %d\n", lineno);
-                        printf("Line so far: %s\n", line);
-                        exit(1);
-                    }
-
-                    value = vars->getVarValueIndex(j, cp);
-                    checkValue(value);
-                }
-                while (*cp && !(isspace(*cp) || (*cp == ',')))
-                    cp++;
-                while (*cp && (isspace(*cp) || (*cp == ',')))
-                    cp++; // now at next value
-                j++;
-            } else { //Anjali
-                // check if it is in LostVar list, if yes then if all its values are valid then this row of table can go
-                // otherwise mark it for being removed from building a key
-                if (lostvarp != NULL) {
-                    b_lostvar = isLostVar(i, &lostvarpt, lostvarp);
-                    if (b_lostvar) {
-                        int ret = sscanf(cp, "%[^\t, ]", var);
-                        if (ret == 1) {
-                            keepval = KeepVal(lostvarpt, var);
-                            if (!keepval)
-                                flag = DISCARD;
-                        } else {
-                            printf("something went wrong");
-                            exit(1);
-                        }
-                    }
-                }
-                while (*cp && !(isspace(*cp) || (*cp == ',')))
-                    cp++;
-                while (*cp && (isspace(*cp) || (*cp == ',')))
-                    cp++; // now at next value
-            } //Anjali
-        }
-        j = 0;
-        while (*cp && (isspace(*cp) || (*cp == ',')))
-            cp++;
-        if (*cp) { // there is still a tuple value on the line
-            tupleValue = (double) strtod(cp, (char **) NULL);
-        } else {
-            tupleValue = 1;
-        }
-        if (flag == KEEP) {
+        LineStatus status = parseDataLine(line, vars, lostvarp, valueIndex, ruleIndex, values, indices, &failVar,
+                &failColumn, &tupleValue, &keep);
+        if (status == LINE_SHORT)
+            reportShortLine(lineno, line);
+        else if (status == LINE_OVERFLOW)
+            reportOverflow(vars, lineno, failColumn, failVar, line);
+        if (keep) {
             Key::buildKey(key, keysize, vars, indices, values, varCount);
-            indata->sumTuple(key, tupleValue);
+            //-- duplicates are merged by the caller's sortAndMerge()
+            if (spill) {
+                if (!spill->add(key, tupleValue)) {
+                    l = -1;
+                    break;
+                }
+            } else
+                indata->addTuple(key, tupleValue);
         }
-        flag = KEEP;
 
         gotLine = Options::getLine(fin, line, &lineno);
         //-- see if there is test data; if so, stop here
@@ -169,6 +566,11 @@ long ocReadData(FILE *fin, VariableList *vars, Table *indata, LostVar *lostvarp)
             break;
         }
     }
+    if (spill) {
+        if (l >= 0 && !spill->finish())
+            l = -1;
+        delete spill;
+    }
     delete[] indices;
     delete[] values;
     delete[] key;
@@ -450,7 +852,6 @@ void ocRebinDefineVar(Options *options, VariableList *vars, LostVar ** lostvarp)
                     //variable is kept*********************var kept*************
                     //Though cardinality might need adjusting
                     //The cardinality (if rebinning is used) is equal to the number of ';'+1
-                    //int oldnewTable[2][MAXCARDINALITY];
                     Variable *varpt = NULL;
                     int card = 1;
                     char* locator = rebin;
@@ -538,10 +939,13 @@ void ocRebinDefineVar(Options *options, VariableList *vars, LostVar ** lostvarp)
                             printf("Error in rebinning string\n");
                             exit(1);
                         }
+                        //-- room for this entry, and the NULL which may follow it
+                        vars->growRebinMap(num_var_actual - 1, index + 2);
                         varpt->oldnew[NEW_ROW][index] = new char[strlen(valp) + 1];
                         strcpy(varpt->oldnew[NEW_ROW][index], valp);
                         cp = rest_tok;
                         for (;;) {
+                            vars->growRebinMap(num_var_actual - 1, index + 2);
                             while (*cp && isspace(*cp))
                                 cp++;
                             ret = sscanf(cp, "%[^, ],%[^; ]", valp, rest_tok);
@@ -580,7 +984,8 @@ void ocRebinDefineVar(Options *options, VariableList *vars, LostVar ** lostvarp)
                         else
                             break;
                     } //end of while for tokenizing
-                    Done: varpt->oldnew[NEW_ROW][index] = NULL; //marks end of mapping
+                    Done: vars->growRebinMap(num_var_actual - 1, index + 1);
+                    varpt->oldnew[NEW_ROW][index] = NULL; //marks end of mapping
 
                 } //end of variable is kept
                 done1: rebin[0] = '\0';
@@ -604,13 +1009,249 @@ void ocRebinDefineVar(Options *options, VariableList *vars, LostVar ** lostvarp)
         for (i = 0; i < vars->getVarCount(); i++)
             vars->getVariable(i)->dv = false;
     }
+    //-- the rebinning maps are complete; compile them for reading the data
+    for (int i = 0; i < vars->getVarCount(); i++) {
+        Variable *varp = vars->getVariable(i);
+        if (varp->rebin || varp->exclude != NULL)
+            vars->compileRebin(i);
+    }
     return;
 }
 
+//-- the data tables, and all made from them, use the layout asked for
+static void ocSetTableLayout(Options *options) {
+    const char *layout;
+    if (options->getOptionString("table-layout", NULL, &layout))
+        Table::setDefaultLayout(strcmp(layout, "columnar") == 0 ? TableLayout::Columnar : TableLayout::Interleaved);
+}
+
+/*
+ * Binary datasets. A dataset holds what ocReadFile makes of a data file: the file's
+ * options (its text up to and including the :data line), the value map of each
+ * variable, and the input and test tuples, sorted and merged, in Table's interleaved
+ * layout. Each table's tuples are stored twice, as read and normalized, along with the
+ * total they were normalized by, as the manager normalizes the data before anything
+ * else, unless the values have to be adjusted first (as for function data). Reading a
+ * dataset defines the variables from the options, as for a data file, and restores the
+ * value maps; the tables use the tuples in place, from a read-only mapping of the file,
+ * so unless they are adjusted they are neither parsed nor copied.
+ *
+ * The file is a DatasetHeader followed by the sections it locates. The magic number
+ * begins with a byte which can't start a text data file, and ends with the version.
+ */
+static const char DATASET_MAGIC[8] = { '\x89', 'O', 'C', 'C', 'D', 'A', 'T', '2' };
+
+struct DatasetHeader {
+    char magic[8];
+    long long keysize;
+    long long varCount;
+    long long dataLines; // as returned by ocReadFile for the data file
+    long long optionsOffset, optionsLength;
+    long long valuesOffset, valuesLength; // for each variable, a count and then that many strings
+    long long inputOffset, inputCount;
+    long long testOffset, testCount; // testOffset is 0 if there is no test data
+    long long inputNormalOffset, testNormalOffset; // the same tuples, normalized
+    double inputSum, testSum; // the totals they were normalized by
+};
+
+static bool ocIsDataset(FILE *fd) {
+    int ch = getc(fd);
+    if (ch != EOF)
+        ungetc(ch, fd);
+    return ch == (unsigned char) DATASET_MAGIC[0];
+}
+
+static int ocReadDataset(FILE *fd, Options *options, Table **indata, Table **testdata, VariableList **vars) {
+    struct stat st;
+    if (fileno(fd) < 0 || fstat(fileno(fd), &st) != 0) {
+        printf("ERROR: datasets can only be read from files\n");
+        return 0;
+    }
+    if ((size_t) st.st_size < sizeof(DatasetHeader)) {
+        printf("ERROR: dataset file is truncated\n");
+        return 0;
+    }
+    size_t length = st.st_size;
+    char *base = (char*) mmap(NULL, length, PROT_READ, MAP_PRIVATE, fileno(fd), 0);
+    if (base == MAP_FAILED) {
+        printf("ERROR: could not map dataset file\n");
+        return 0;
+    }
+    DatasetHeader *header = (DatasetHeader*) base;
+    long long tupleBytes = header->keysize * sizeof(KeySegment) + sizeof(ocTupleValue);
+    auto inFile = [&](long long offset, long long size) {
+        return offset >= (long long) sizeof(DatasetHeader) && size >= 0 && offset + size <= (long long) length;
+    };
+    if (memcmp(header->magic, DATASET_MAGIC, sizeof(DATASET_MAGIC)) != 0 || header->keysize <= 0
+            || !inFile(header->optionsOffset, header->optionsLength)
+            || !inFile(header->valuesOffset, header->valuesLength)
+            || !inFile(header->inputOffset, header->inputCount * tupleBytes)
+            || !inFile(header->inputNormalOffset, header->inputCount * tupleBytes)
+            || (header->testOffset != 0 && (!inFile(header->testOffset, header->testCount * tupleBytes)
+                    || !inFile(header->testNormalOffset, header->testCount * tupleBytes)))) {
+        printf("ERROR: dataset file is not valid\n");
+        munmap(base, length);
+        return 0;
+    }
+
+    VariableList *varp = new VariableList(8);
+    LostVar *lostvarp = NULL;
+    *vars = varp;
+    FILE *text = fmemopen(base + header->optionsOffset, header->optionsLength, "r");
+    options->readOptions(text);
+    fclose(text);
+    ocRebinDefineVar(options, varp, &lostvarp);
+    ocSetTableLayout(options);
+    if (varp->getVarCount() != header->varCount || varp->getKeySize() != header->keysize) {
+        printf("ERROR: dataset file does not match its variable definitions\n");
+        munmap(base, length);
+        return 0;
+    }
+    const char *cp = base + header->valuesOffset;
+    const char *end = cp + header->valuesLength;
+    for (int j = 0; j < varp->getVarCount(); j++) {
+        long long count;
+        if (cp + sizeof(count) > end) {
+            printf("ERROR: dataset file is not valid\n");
+            munmap(base, length);
+            return 0;
+        }
+        memcpy(&count, cp, sizeof(count));
+        cp += sizeof(count);
+        for (long long k = 0; k < count; k++) {
+            const char *value = cp;
+            cp += strnlen(cp, end - cp) + 1;
+            if (cp > end) {
+                printf("ERROR: dataset file is not valid\n");
+                munmap(base, length);
+                return 0;
+            }
+            varp->getVarValueIndex(j, value);
+        }
+    }
+
+    //-- each table gets its own mapping, which it releases when done with it
+    auto mapTable = [&](long long offset, long long normalOffset, double sum, long long count) {
+        void *map = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fileno(fd), 0);
+        if (map == MAP_FAILED) {
+            printf("ERROR: could not map dataset file\n");
+            exit(1);
+        }
+        Table *table = new Table(header->keysize, 1);
+        table->attachMapped(map, length, (char*) map + offset, count);
+        table->attachNormalized((char*) map + normalOffset, sum);
+        return table;
+    };
+    *indata = mapTable(header->inputOffset, header->inputNormalOffset, header->inputSum, header->inputCount);
+    if (header->testOffset != 0)
+        *testdata = mapTable(header->testOffset, header->testNormalOffset, header->testSum, header->testCount);
+    int dataLines = header->dataLines;
+    munmap(base, length);
+
+    bool result = varp->checkCardinalities();
+    if (result == false)
+        exit(1);
+    return dataLines;
+}
+
+//-- write the tuples of table, with each value divided by denom
+static bool writeTuples(FILE *fp, Table *table, double denom, long long *offset) {
+    //-- tuples are aligned for their key segments and values
+    long pos = ftell(fp);
+    static const char zeros[8] = { 0 };
+    long pad = (8 - pos % 8) % 8;
+    if (pad > 0 && fwrite(zeros, 1, pad, fp) != (size_t) pad)
+        return false;
+    *offset = pos + pad;
+    int keysize = table->getKeySize();
+    for (long long i = 0; i < table->getTupleCount(); i++) {
+        ocTupleValue value = table->getValue(i) / denom;
+        if (fwrite(table->getKey(i), sizeof(KeySegment), keysize, fp) != (size_t) keysize
+                || fwrite(&value, sizeof(value), 1, fp) != 1)
+            return false;
+    }
+    return true;
+}
+
+//-- write the tuples of table as read, and normalized (summed in the order of
+//-- Table::normalize, so the values come out the same)
+static bool writeTable(FILE *fp, Table *table, long long *offset, long long *normalOffset, long long *count,
+        double *sum) {
+    *count = table->getTupleCount();
+    *sum = 0;
+    for (long long i = 0; i < *count; i++)
+        *sum += table->getValue(i);
+    return writeTuples(fp, table, 1.0, offset) && writeTuples(fp, table, *sum, normalOffset);
+}
+
+bool ocWriteDataset(const char *path, FILE *source, int dataLines, Table *indata, Table *testdata,
+        VariableList *vars) {
+    //-- the options are the source's text through its :data line
+    char line[MAXLINE + 1];
+    int lineno = 0;
+    rewind(source);
+    while (Options::getLine(source, line, &lineno) && strcmp(line, ":data") != 0)
+        ;
+    long optionsLength = ftell(source);
+    char *options = new char[optionsLength];
+    rewind(source);
+    bool ok = fread(options, 1, optionsLength, source) == (size_t) optionsLength;
+
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL) {
+        printf("ERROR: could not open %s\n", path);
+        delete[] options;
+        return false;
+    }
+    DatasetHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, DATASET_MAGIC, sizeof(DATASET_MAGIC));
+    header.keysize = vars->getKeySize();
+    header.varCount = vars->getVarCount();
+    header.dataLines = dataLines;
+    ok = ok && fwrite(&header, sizeof(header), 1, fp) == 1;
+    header.optionsOffset = sizeof(header);
+    header.optionsLength = optionsLength;
+    ok = ok && fwrite(options, 1, optionsLength, fp) == (size_t) optionsLength;
+    delete[] options;
+
+    header.valuesOffset = ftell(fp);
+    for (int j = 0; ok && j < vars->getVarCount(); j++) {
+        Variable *var = vars->getVariable(j);
+        long long count = var->valueCount;
+        ok = fwrite(&count, sizeof(count), 1, fp) == 1;
+        for (long long k = 0; ok && k < count; k++)
+            ok = fwrite(var->valmap[k], 1, strlen(var->valmap[k]) + 1, fp) == strlen(var->valmap[k]) + 1;
+    }
+    header.valuesLength = ftell(fp) - header.valuesOffset;
+    ok = ok && writeTable(fp, indata, &header.inputOffset, &header.inputNormalOffset, &header.inputCount,
+            &header.inputSum);
+    if (testdata)
+        ok = ok && writeTable(fp, testdata, &header.testOffset, &header.testNormalOffset, &header.testCount,
+                &header.testSum);
+    ok = ok && fseek(fp, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, fp) == 1;
+    ok = (fclose(fp) == 0) && ok;
+    if (!ok)
+        printf("ERROR: could not write %s\n", path);
+    return ok;
+}
+
+//-- report why ocReadData failed: the input (including a decompressor, see below) or a
+//-- data-memory spill file. Returns 0, as ocReadFile does when it fails.
+static int reportReadError(FILE *fd) {
+    if (ferror(fd))
+        printf("ERROR: could not read the data: %s\n", strerror(errno));
+    else
+        printf("ERROR: could not write a temporary file for data-memory: %s\n", strerror(errno));
+    return 0;
+}
+
 /*
- * oldRead - read old format files.
+ * oldRead - read old format files, or binary datasets (see above).
  */
 int ocReadFile(FILE *fd, Options *options, Table **indata, Table **testdata, VariableList **vars) {
+    if (fd && ocIsDataset(fd))
+        return ocReadDataset(fd, options, indata, testdata, vars);
     VariableList *varp = NULL;
     Table *indatap = NULL;
     Table *testdatap = NULL;
@@ -620,22 +1261,182 @@ int ocReadFile(FILE *fd, Options *options, Table **indata, Table **testdata, Var
     *vars = varp = new VariableList(8);
     if (fd) {
         options->readOptions(fd);
+        if (ferror(fd))
+            return reportReadError(fd);
     }
     ocRebinDefineVar(options, varp, &lostvarp);
+    //-- data files are parsed with parse-threads threads (0 = all cores)
+    double value;
+    int threads = options->getOptionFloat("parse-threads", NULL, &value) ? ocThreadCount((int) value) : 1;
+    //-- with data-memory (in MB), data are summed as they are read, spilling to disk as needed
+    long long memoryLimit = options->getOptionFloat("data-memory", NULL, &value) ? (long long) (value * 1048576) : 0;
+    ocSetTableLayout(options);
     //-- If not at end of file, there is data in this file
-    if (!feof(fd)) {
+    if (!feof(fd) && !ferror(fd)) {
         *indata = indatap = new Table(varp->getKeySize(), 64);
-        dataLines = ocReadData(fd, varp, indatap, lostvarp);
-        indatap->sort();
+        dataLines = ocReadData(fd, varp, indatap, lostvarp, threads, memoryLimit);
+        if (dataLines < 0 || ferror(fd))
+            return reportReadError(fd);
+        indatap->sortAndMerge();
     }
     //-- If there's still data, then it must be test data
-    if (!feof(fd)) {
+    if (!feof(fd) && !ferror(fd)) {
         *testdata = testdatap = new Table(varp->getKeySize(), 64);
-        testLines = ocReadData(fd, varp, testdatap, lostvarp);
-        testdatap->sort();
+        testLines = ocReadData(fd, varp, testdatap, lostvarp, threads, memoryLimit);
+        if (testLines < 0 || ferror(fd))
+            return reportReadError(fd);
+        testdatap->sortAndMerge();
     }
     bool result = varp->checkCardinalities();
     if (result == false)
         exit(1);
     return dataLines;
 }
+
+/*
+ * Input streams. ocOpenInput opens data files for ocReadFile, taking "-" as the standard
+ * input. Input compressed with gzip or zstd is read through the decompressor (gzip -dc or
+ * zstd -dc), which a feeder thread supplies from the file or pipe, so uploads and logs
+ * need not be unpacked to disk first. Other files are opened as usual, so binary datasets
+ * and the parallel parser, which map the file, still work with them. Read errors, and a
+ * decompressor which fails, leave the stream's error set (with errno EIO for the latter).
+ */
+struct InputStream {
+    FILE *source;
+    const char *name;
+    unsigned char head[4]; // bytes read to recognize the format, which still have to be read
+    size_t headLength, headPos;
+    const char *command; // the decompressor, or NULL
+    int fd; // the decompressor's output
+    pid_t pid;
+    std::thread feeder;
+};
+
+static void feedDecompressor(InputStream *in, int fd) {
+    //-- if the decompressor quits, writes fail (with EPIPE) rather than ending the program
+    sigset_t pipeSignal;
+    sigemptyset(&pipeSignal);
+    sigaddset(&pipeSignal, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipeSignal, NULL);
+    char buffer[65536];
+    memcpy(buffer, in->head, in->headLength);
+    size_t length = in->headLength;
+    do {
+        for (size_t done = 0; done < length;) {
+            ssize_t n = write(fd, buffer + done, length - done);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0) {
+                close(fd);
+                return;
+            }
+            done += n;
+        }
+        length = fread(buffer, 1, sizeof(buffer), in->source);
+    } while (length > 0);
+    close(fd);
+}
+
+static bool startDecompressor(InputStream *in) {
+    int toChild[2], fromChild[2];
+    if (pipe2(toChild, O_CLOEXEC) != 0)
+        return false;
+    if (pipe2(fromChild, O_CLOEXEC) != 0) {
+        close(toChild[0]);
+        close(toChild[1]);
+        return false;
+    }
+    fflush(stdout);
+    in->pid = fork();
+    if (in->pid == 0) {
+        dup2(toChild[0], 0);
+        dup2(fromChild[1], 1);
+        execlp(in->command, in->command, "-dc", (char*) NULL);
+        _exit(127);
+    }
+    close(toChild[0]);
+    close(fromChild[1]);
+    if (in->pid < 0) {
+        close(toChild[1]);
+        close(fromChild[0]);
+        return false;
+    }
+    in->fd = fromChild[0];
+    in->feeder = std::thread(feedDecompressor, in, toChild[1]);
+    return true;
+}
+
+static ssize_t inputRead(void *cookie, char *buf, size_t size) {
+    InputStream *in = (InputStream*) cookie;
+    if (in->command == NULL) {
+        size_t n = 0;
+        while (n < size && in->headPos < in->headLength)
+            buf[n++] = in->head[in->headPos++];
+        n += fread(buf + n, 1, size - n, in->source);
+        return (n == 0 && ferror(in->source)) ? -1 : n;
+    }
+    ssize_t n;
+    do {
+        n = read(in->fd, buf, size);
+    } while (n < 0 && errno == EINTR);
+    if (n == 0 && in->pid > 0) {
+        //-- at the end, make sure the decompressor read all the input
+        int status;
+        waitpid(in->pid, &status, 0);
+        in->pid = 0;
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            errno = EIO;
+            return -1;
+        }
+    }
+    return n;
+}
+
+static int inputClose(void *cookie) {
+    InputStream *in = (InputStream*) cookie;
+    if (in->command) {
+        //-- closing the pipe stops a decompressor which is still writing, and so the feeder
+        close(in->fd);
+        in->feeder.join();
+        if (in->pid > 0)
+            waitpid(in->pid, NULL, 0);
+    }
+    if (in->source != stdin)
+        fclose(in->source);
+    delete in;
+    return 0;
+}
+
+FILE *ocOpenInput(const char *fname) {
+    bool isStdin = strcmp(fname, "-") == 0;
+    FILE *source = isStdin ? stdin : fopen(fname, "r");
+    if (source == NULL)
+        return NULL;
+    InputStream *in = new InputStream();
+    in->source = source;
+    in->name = isStdin ? "standard input" : fname;
+    in->headLength = fread(in->head, 1, sizeof(in->head), source);
+    in->headPos = 0;
+    in->command = NULL;
+    in->fd = -1;
+    in->pid = 0;
+    static const unsigned char gzipMagic[2] = { 0x1f, 0x8b };
+    static const unsigned char zstdMagic[4] = { 0x28, 0xb5, 0x2f, 0xfd };
+    if (in->headLength >= sizeof(gzipMagic) && memcmp(in->head, gzipMagic, sizeof(gzipMagic)) == 0)
+        in->command = "gzip";
+    else if (in->headLength >= sizeof(zstdMagic) && memcmp(in->head, zstdMagic, sizeof(zstdMagic)) == 0)
+        in->command = "zstd";
+    if (in->command == NULL && !isStdin && fseek(source, 0, SEEK_SET) == 0) {
+        delete in;
+        return source;
+    }
+    if (in->command && !startDecompressor(in)) {
+        printf("ERROR: could not start %s to read %s\n", in->command, in->name);
+        if (!isStdin)
+            fclose(source);
+        delete in;
+        return NULL;
+    }
+    cookie_io_functions_t functions = { inputRead, NULL, NULL, inputClose };
+    return fopencookie(in, "r", functions);
+}
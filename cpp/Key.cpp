@@ -24,7 +24,7 @@ void Key::buildKey(KeySegment *key, int keysize, class VariableList *vars,
         Variable *var = vars->getVariable(varindices[i]);
         KeySegment mask = var->mask;
         int segment = var->segment;
-        key[segment] = (key[segment] & ~mask) | ((varvalues[i] << var->shift) & mask);
+        key[segment] = (key[segment] & ~mask) | (((KeySegment) varvalues[i] << var->shift) & mask);
     }
 }
 
@@ -41,7 +41,7 @@ void Key::buildFullKey(KeySegment *key, int keysize, class VariableList *vars, i
         Variable *var = vars->getVariable(i);
         KeySegment mask = var->mask;
         int segment = var->segment;
-        key[segment] = (key[segment] & ~mask) | ((varvalues[i] << var->shift) & mask);
+        key[segment] = (key[segment] & ~mask) | (((KeySegment) varvalues[i] << var->shift) & mask);
     }
 }
 
@@ -54,7 +54,7 @@ void Key::setKeyValue(KeySegment *key, int keysize, class VariableList *vars, in
     Variable *var = vars->getVariable(index);
     int segment = var->segment;
     KeySegment mask = var->mask;
-    key[segment] = (key[segment] & ~mask) | ((value << var->shift) & mask);
+    key[segment] = (key[segment] & ~mask) | (((KeySegment) value << var->shift) & mask);
 }
 
 
@@ -225,9 +225,9 @@ void Key::getSiblings(KeySegment *key, VariableList *vars, Table *table, long *i
 void Key::dumpKey(KeySegment *key, int keysize)
 {
     for (int k = 0; k < keysize; k++) {
-        printf("%08lx ", key[k]);
+        printf("%0*lx ", (int) sizeof(KeySegment) * 2, key[k]);
     }
 }
 
 
-
+int Key::fixedKeyLimit = 4;
@@ -10,6 +10,7 @@
 #include <gmp.h>
 #include <fenv.h>
 #include <math.h>
+#include "DenseTable.h"
 #include "Input.h"
 #include "Key.h"
 #include "ManagerBase.h"
@@ -17,6 +18,8 @@
 #include "Model.h"
 #include "ModelCache.h"
 #include "Options.h"
+#include "Parallel.h"
+#include "ProjectionCache.h"
 #include "RelCache.h"
 #include "Relation.h"
 #include "StateConstraint.h"
@@ -26,12 +29,17 @@
 #include <assert.h>
 #include <cxxabi.h>
 #include <execinfo.h>
+#include <limits.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 #include <algorithm>
+#include <atomic>
+#include <unordered_set>
+#include <vector>
 using std::min;
 using std::make_pair;
 using std::pair;
@@ -151,9 +159,17 @@ ManagerBase::ManagerBase(VariableList *vars, Table *input) :
     inputH = -1;
     stateSpaceSize = 0;
     dataLines = 0;
+    loadTime = 0;
     fitTable1 = NULL;
     fitTable2 = NULL;
     projTable = NULL;
+    warmStartPaused = false;
+    projectionData = NULL;
+    projectionCount = projectionSupersetHits = projectionSourceTuples = 0;
+    tablesReleased = 0;
+    batchSince = ULLONG_MAX;
+    diskCache = NULL;
+    junctionTreeWarned = false;
     inputData = testData = NULL;
     DVOrder = NULL;
     searchDirection = Direction::Ascending;
@@ -179,6 +195,8 @@ ManagerBase::~ManagerBase() {
     if (fitTable1) delete fitTable1;
     if (fitTable2) delete fitTable2;
     if (projTable) delete projTable;
+    clearFitCache();
+    if (diskCache) delete diskCache;
     if (intersectArray) delete[] intersectArray;
     if (DVOrder) delete[] DVOrder;
     delete options;
@@ -270,8 +288,8 @@ Relation *ManagerBase::getRelation(int *input_vars, int varcount, bool make_proj
         for (int i = 0; i < varcount; i++) {
             rel->addVariable(varindices[i], stateindices[i]);
         }
-        if (!relCache->addRelation(rel)) {
-            Relation *cached_rel = relCache->findRelation(rel->getPrintName());
+        Relation *cached_rel = relCache->findOrAddRelation(rel);
+        if (cached_rel != rel) {
             delete rel;
             rel = cached_rel;
         } else {
@@ -297,8 +315,8 @@ Relation *ManagerBase::getRelation(int *input_vars, int varcount, bool make_proj
         for (int i = 0; i < varcount; i++) {
             rel->addVariable(varindices[i]);
         }
-        if (!relCache->addRelation(rel)) {
-            Relation *cached_rel = relCache->findRelation(rel->getPrintName());
+        Relation *cached_rel = relCache->findOrAddRelation(rel);
+        if (cached_rel != rel) {
             delete rel;
             rel = cached_rel;
         }
@@ -328,89 +346,98 @@ Relation *ManagerBase::getChildRelation(Relation *rel, int skip, bool makeProjec
 }
 
 // This function is a special case of the other makeProjection(), further below.
-// It projects the input data into the table for a relation.
+// It projects the input data into the table for a relation. Any relation already in the
+// cache with a table, and containing this one, holds a projection of the same data, so
+// the smallest such table is used as the source when it is smaller than the input.
 bool ManagerBase::makeProjection(Relation *rel) {
+    relCache->touch(rel);
     if (rel->getTable())
         return true; // table already computed
+    ProjectionCache *cache = rel->isStateBased() ? NULL : getDiskCache();
+    if (cache) {
+        Table *cached = cache->load(rel);
+        if (cached) {
+            rel->setTable(cached);
+            relCache->addTable(rel);
+            return true;
+        }
+    }
+    Table *source = projectionSource(rel);
 
     //-- create the projection data for a given relation. Go through
-    //-- the inputData, and for each tuple, sum it into the table for the relation.
+    //-- the source, and for each tuple, sum it into the table for the relation.
     long long start_size = rel->getNC();
-    if ((inputData->getTupleCount() < start_size) || (start_size <= 0)) {
-        start_size = inputData->getTupleCount();
+    if ((source->getTupleCount() < start_size) || (start_size <= 0)) {
+        start_size = source->getTupleCount();
     }
     //logProjection(rel->getPrintName());
     Table *table = new Table(keysize, start_size);
     rel->setTable(table);
-    makeProjection(inputData, table, rel);
+    makeProjection(source, table, rel);
+    relCache->addTable(rel);
+    if (cache)
+        cache->save(rel, table);
     return true;
 }
 
+Table *ManagerBase::projectionSource(Relation *rel) {
+    //-- cached tables only hold projections of the data they were made from; while
+    //-- inputData is swapped for something else (as in projectedFit), use it directly
+    if (projectionData == NULL)
+        projectionData = inputData;
+    Table *source = inputData;
+    if (inputData == projectionData && !rel->isStateBased()) {
+        Relation *superset = relCache->findSmallestSuperset(rel);
+        if (superset && superset->getTable()->getTupleCount() < inputData->getTupleCount()) {
+            source = superset->getTable();
+            projectionSupersetHits++;
+        }
+    }
+    projectionCount++;
+    projectionSourceTuples += source->getTupleCount();
+    return source;
+}
+
 // This function projects the data in table t1 into (empty) table t2, based on the relation.
 bool ManagerBase::makeProjection(Table *t1, Table *t2, Relation *rel) {
     //-- create the projection data for a given relation. Go through
     //-- the inputData, and for each tuple, sum it into the table for the relation.
+    if (!rel->isStateBased()) {
+        //-- a plain relation is a group-by on its mask: sort once and merge the runs
+        t2->reset(keysize);
+        t2->groupBy(t1, rel->getMask());
+        return true;
+    }
+    //-- state based, so if the key matches one of the constraints we keep it,
+    //-- otherwise add it to the remainder to be split up later
     long long count = t1->getTupleCount();
     t2->reset(keysize); // reset the output table
+    t2->beginHashed(); // accumulate unsorted, then sort once at the end
     KeySegment *key = new KeySegment[keysize];
     KeySegment *mask = rel->getMask();
-    long i, j, k;
-    double value;
-
-    bool is_match = false;  // for state-based
-    double remainder = 0;   // for state-based
-    long c_count;            // for state-based
-    KeySegment *const_k;  // for state-based
-    if (rel->isStateBased()) { // for state-based
-        c_count = rel->getStateConstraints()->getConstraintCount();
-        makeSbExpansion(rel, t2);
-    }
-    for (i = 0; i < count; i++) {
-        t1->copyKey(i, key);
-        value = t1->getValue(i);
+    StateConstraint *constraints = rel->getStateConstraints();
+    long c_count = constraints->getConstraintCount();
+    double remainder = 0;
+    makeSbExpansion(rel, t2);
+    for (long long i = 0; i < count; i++) {
         //-- set all the variables in the key to dont_care if they don't exist in the relation
-        for (k = 0; k < keysize; k++) {
-            key[k] |= mask[k];
-        }
-        if (!rel->isStateBased()) {
+        Key::applyMask(key, t1->getKey(i), mask, keysize);
+        double value = t1->getValue(i);
+        if (constraints->indexOf(key) >= 0) {
             t2->sumTuple(key, value);
         } else {
-            // state based, so if the key matches one of the constraints we keep it,
-            // otherwise add it to the remainder to be split up later
-            for (j = 0; j < c_count; j++) {
-                is_match = false;
-                const_k = rel->getStateConstraints()->getConstraint(j);
-                if (Key::compareKeys(key, const_k, keysize) == 0) {
-                    is_match = true;
-                    break;
-                }
-            }
-            if (is_match) {
-                t2->sumTuple(key, value);
-            } else {
-                remainder += value;
-            }
+            remainder += value;
         }
     }
-    if (rel->isStateBased()) {
-        // now, for SB relations, spread remainder through unused cells
-        count = t2->getTupleCount();
-        double spread = remainder / (count - c_count);
-        for (i = 0; i < count; i++) {
-            is_match = false;
-            for (j = 0; j < c_count; j++) {
-                const_k = rel->getStateConstraints()->getConstraint(j);
-                if (Key::compareKeys(t2->getKey(i), const_k, keysize) == 0) {
-                    is_match = true;
-                    break;
-                }
-            }
-            if (is_match == false) {
-                t2->setValue(i, spread);
-            }
+    //-- now spread the remainder through the unconstrained cells
+    count = t2->getTupleCount();
+    double spread = remainder / (count - c_count);
+    for (long long i = 0; i < count; i++) {
+        if (constraints->indexOf(t2->getKey(i)) < 0) {
+            t2->setValue(i, spread);
         }
     }
-    t2->sort();
+    t2->finalize();
     delete[] key;
     return true;
 }
@@ -436,7 +463,6 @@ bool ManagerBase::makeMaxProjection(Table *qt, Table *maxpt, Table *inputData, R
     KeySegment *key = new KeySegment[keysize];
     KeySegment *mask = indRel->getMask();
     long long i, pindex, maxqindex, maxpindex, dvindex;
-    int k;
     double qvalue, pvalue, maxqvalue;
     int qdv, pdv, maxdv;
     int defaultDV = getDefaultDVIndex();
@@ -449,8 +475,7 @@ bool ManagerBase::makeMaxProjection(Table *qt, Table *maxpt, Table *inputData, R
             pvalue = inputData->getValue(pindex);
         qdv = Key::getKeyValue(key, keysize, varList, varList->getDV());
         //-- set up key to match just IVs
-        for (k = 0; k < keysize; k++)
-            key[k] |= mask[k];
+        Key::applyMask(key, key, mask, keysize);
         maxqindex = maxqt->indexOf(key);
         maxpindex = maxpt->indexOf(key);
         dvindex = dvt->indexOf(key);
@@ -491,9 +516,7 @@ bool ManagerBase::makeMaxProjection(Table *qt, Table *maxpt, Table *inputData, R
         count = inputData->getTupleCount();
         (*missedValues) = 0;
         for (i = 0; i < count; i++) {
-            inputData->copyKey(i, key);
-            for (k = 0; k < keysize; k++)
-                key[k] |= mask[k];
+            Key::applyMask(key, inputData->getKey(i), mask, keysize);
             if (maxpt->indexOf(key) >= 0) {
                 continue; //-- model predicts this; don't need default
             } else {
@@ -678,22 +701,165 @@ Relation *ManagerBase::getDepRelation() {
 
 bool ManagerBase::makeProjections(Model *model) {
     //-- create projections for all relations in model
+    unsigned long long since = relCache->getUseClock();
     int count = model->getRelationCount();
     for (int i = 0; i < count; i++) {
         if (!makeProjection(model->getRelation(i)))
             return false;
     }
+    trimTableCache(since);
     return true;
 }
 
+/**
+ * makeProjections - the relations still needing tables are projected in waves. A wave
+ * holds the relations not contained in any other pending one, so the rest can read from
+ * the tables it makes. Within a wave, sources are chosen and tables allocated on this
+ * thread, the projections run concurrently (each writes only its own table), and the
+ * tables are installed afterwards. State-based relations are projected one at a time.
+ */
+bool ManagerBase::makeProjections(Model **models, int modelCount) {
+    unsigned long long since = relCache->getUseClock();
+    //-- the batch's models are evaluated next, so keep its tables until the next batch
+    batchSince = since;
+    ProjectionCache *cache = getDiskCache();
+    std::vector<Relation*> pending;
+    std::unordered_set<Relation*> seen;
+    for (int m = 0; m < modelCount; m++) {
+        for (int r = 0; r < models[m]->getRelationCount(); r++) {
+            Relation *rel = models[m]->getRelation(r);
+            relCache->touch(rel);
+            if (rel->getTable())
+                continue;
+            if (rel->isStateBased()) {
+                makeProjection(rel);
+                continue;
+            }
+            Table *cached = cache ? cache->load(rel) : NULL;
+            if (cached) {
+                rel->setTable(cached);
+                relCache->addTable(rel);
+                continue;
+            }
+            if (seen.insert(rel).second)
+                pending.push_back(rel);
+        }
+    }
+    int threads = getProjectionThreads();
+    if (threads <= 1) {
+        for (size_t i = 0; i < pending.size(); i++) {
+            makeProjection(pending[i]);
+        }
+        trimTableCache(since);
+        return true;
+    }
+    while (!pending.empty()) {
+        //-- if a larger pending relation contains one, so does a wave member, so taking them
+        //-- largest first, each is checked against the wave members so far which share
+        //-- whichever of its variables the fewest members have
+        std::vector<Relation*> order(pending);
+        std::stable_sort(order.begin(), order.end(), [](Relation *a, Relation *b) {
+            return a->getVariableCount() > b->getVariableCount();
+        });
+        std::vector<std::vector<Relation*> > byVariable(varList->getVarCount());
+        std::unordered_set<Relation*> inWave;
+        for (size_t i = 0; i < order.size(); i++) {
+            Relation *rel = order[i];
+            std::vector<Relation*> *members = NULL;
+            for (int v = 0; v < rel->getVariableCount(); v++) {
+                std::vector<Relation*> &list = byVariable[rel->getVariable(v)];
+                if (members == NULL || list.size() < members->size())
+                    members = &list;
+            }
+            bool contained = members == NULL && !inWave.empty();
+            for (size_t j = 0; members && j < members->size() && !contained; j++) {
+                contained = (*members)[j]->getVariableCount() > rel->getVariableCount()
+                        && (*members)[j]->contains(rel);
+            }
+            if (contained)
+                continue;
+            inWave.insert(rel);
+            for (int v = 0; v < rel->getVariableCount(); v++) {
+                byVariable[rel->getVariable(v)].push_back(rel);
+            }
+        }
+        std::vector<Relation*> wave, rest;
+        for (size_t i = 0; i < pending.size(); i++) {
+            (inWave.count(pending[i]) ? wave : rest).push_back(pending[i]);
+        }
+        long long count = wave.size();
+        std::vector<Table*> sources(count), tables(count);
+        for (long long i = 0; i < count; i++) {
+            sources[i] = projectionSource(wave[i]);
+            long long start_size = wave[i]->getNC();
+            if ((sources[i]->getTupleCount() < start_size) || (start_size <= 0))
+                start_size = sources[i]->getTupleCount();
+            tables[i] = new Table(keysize, start_size);
+            //-- the mask is built on first use; build it here, so the threads below only read it
+            wave[i]->getMask();
+        }
+        //-- one relation at a time per thread, as their sizes vary widely
+        std::atomic<long long> next(0);
+        parallelFor(threads, count < threads ? count : threads, [&](long long, long long, int) {
+            for (long long i = next++; i < count; i = next++)
+                makeProjection(sources[i], tables[i], wave[i]);
+        });
+        for (long long i = 0; i < count; i++) {
+            wave[i]->setTable(tables[i]);
+            relCache->addTable(wave[i]);
+            if (cache)
+                cache->save(wave[i], tables[i]);
+        }
+        pending.swap(rest);
+    }
+    trimTableCache(since);
+    return true;
+}
+
+ProjectionCache *ManagerBase::getDiskCache() {
+    //-- like the superset sources, this only serves projections of the original data
+    if (projectionData == NULL)
+        projectionData = inputData;
+    if (inputData != projectionData)
+        return NULL;
+    if (diskCache == NULL) {
+        const char *dir;
+        if (!getOptionString("projection-cache", NULL, &dir) || *dir == '\0')
+            return NULL;
+        diskCache = new ProjectionCache(dir, inputData);
+    }
+    return diskCache;
+}
+
+/**
+ * trimTableCache - this is only called once the tables a caller needs have all been
+ * projected; those were used after since, so they stay, as do those of the last batch
+ * from makeProjections(Model**, int), which are still to be used. Any older table may
+ * go, as code which finds a relation's table missing projects it again.
+ */
+void ManagerBase::trimTableCache(unsigned long long since) {
+    double budget;
+    if (!getOptionFloat("table-budget", NULL, &budget) || budget <= 0)
+        return;
+    if (batchSince < since)
+        since = batchSince;
+    tablesReleased += relCache->trimTables((long long) (budget * 1024 * 1024), since, inputData);
+}
+
 void ManagerBase::deleteTablesFromCache() {
     relCache->deleteTables();
 }
 
 bool ManagerBase::deleteModelFromCache(Model *model) {
+    dropWarmStart(model);
     return modelCache->deleteModel(model);
 }
 
+void ManagerBase::reclaimCaches() {
+    modelCache->reclaim();
+    relCache->reclaim();
+}
+
 //-- intersect two variable lists, producing a third. returns true if intersection
 //-- is not empty, and returns the list and count of common variables
 static bool intersect(Relation *rel1, Relation *rel2, int* &var, int &count) {
@@ -747,7 +913,177 @@ void ManagerBase::expandTuple(double tupleValue, KeySegment *key, int *missingVa
     }
 }
 
+int ManagerBase::getProjectionThreads() {
+    double threads;
+    if (!getOptionFloat("projection-threads", NULL, &threads))
+        threads = 1;
+    return ocThreadCount((int) threads);
+}
+
+bool ManagerBase::useIPFAcceleration() {
+    double accelerate;
+    return getOptionFloat("ipf-accelerate", NULL, &accelerate) && accelerate > 0;
+}
+
+int ManagerBase::getIPFThreads() {
+    double threads;
+    if (!getOptionFloat("ipf-threads", NULL, &threads))
+        threads = 1;
+    return ocThreadCount((int) threads);
+}
+
+bool ManagerBase::useDenseTables() {
+    double threshold;
+    if (!getOptionFloat("dense-threshold", NULL, &threshold))
+        return false;
+    //-- cell maps are 32-bit
+    if (threshold > 4294967295.0)
+        threshold = 4294967295.0;
+    return DenseTable::fits(varList, threshold);
+}
+
+bool ManagerBase::useJunctionTree() {
+    const char *method;
+    return getOptionString("fit-method", NULL, &method) && strcmp(method, "junction-tree") == 0;
+}
+
+int ManagerBase::warmStartLevels() {
+    double levels;
+    if (!getOptionFloat("ipf-warm-start", NULL, &levels) || levels < 1)
+        return 0;
+    //-- like the relation caches, this only serves fits of the original data (projectionData
+    //-- is set when the first projection is made; until then, inputData is the original)
+    if (projectionData != NULL && inputData != projectionData)
+        return 0;
+    return (int) levels;
+}
+
+//-- the search level of a model: how many progenitors it has above it
+static int searchLevel(Model *model) {
+    int level = 0;
+    for (Model *progenitor = model->getProgenitor(); progenitor && progenitor != model && level < 1000;
+            progenitor = progenitor->getProgenitor())
+        level++;
+    return level;
+}
+
+/**
+ * findWarmStart - a model found by an upward search adds a relation to its progenitor, so
+ * every margin the model fits is a margin of the data that the progenitor's fit already
+ * matches, apart from the new one. Starting IPF from that fit rather than the orthogonal
+ * expansion converges to the same table in fewer passes. The progenitor's fit is also
+ * zero only where one of its margins is, and those cells are zero in the model's fit, so
+ * its support is large enough.
+ *
+ * A progenitor without loops gets its statistics algebraically, which never builds its
+ * whole fit table, so it is fit here instead, the first time one of its children needs it.
+ * Without loops, this takes a single IPF pass, which its children share.
+ */
+Table *ManagerBase::findWarmStart(Model *model, Model *&source) {
+    source = NULL;
+    if (warmStartPaused || warmStartLevels() == 0)
+        return NULL;
+    Model *progenitor = model->getProgenitor();
+    if (progenitor == NULL || progenitor == model || progenitor->isStateBased() || !model->containsModel(progenitor))
+        return NULL;
+    std::string name = progenitor->getPrintName();
+    std::list<CachedFit>::iterator it;
+    for (it = fitCache.begin(); it != fitCache.end(); it++) {
+        if (it->name == name) {
+            source = progenitor;
+            return it->table;
+        }
+    }
+    if (hasLoops(progenitor))
+        return NULL;
+    //-- keep the progenitor's own IPF attributes, which this fit isn't part of
+    const char *attrs[] = { ATTRIBUTE_IPF_ITERATIONS, ATTRIBUTE_IPF_ERROR, ATTRIBUTE_IPF_RATE,
+            ATTRIBUTE_IPF_WARM_START };
+    double values[4];
+    for (int a = 0; a < 4; a++)
+        values[a] = progenitor->getAttribute(attrs[a]);
+    warmStartPaused = true;
+    makeFitTableIPF(progenitor);
+    warmStartPaused = false;
+    for (int a = 0; a < 4; a++)
+        progenitor->setAttribute(attrs[a], values[a]);
+    saveWarmStart(progenitor);
+    source = progenitor;
+    return fitCache.front().table;
+}
+
+void ManagerBase::saveWarmStart(Model *model) {
+    int levels = warmStartLevels();
+    if (levels == 0)
+        return;
+    std::string name = model->getPrintName();
+    int level = searchLevel(model);
+    //-- drop the model's old fit, and fits from more than levels search levels back,
+    //-- reusing the storage of one of them
+    Table *table = NULL;
+    std::list<CachedFit>::iterator it = fitCache.begin();
+    while (it != fitCache.end()) {
+        if (it->name == name || it->level < level - levels) {
+            if (table) delete table;
+            table = it->table;
+            it = fitCache.erase(it);
+        } else {
+            it++;
+        }
+    }
+    if (table == NULL)
+        table = new Table(keysize, fitTable1->getTupleCount() + 1);
+    table->copy(fitTable1);
+    CachedFit fit = { name, level, table };
+    fitCache.push_front(fit);
+}
+
+void ManagerBase::dropWarmStart(Model *model) {
+    if (fitCache.empty())
+        return;
+    std::string name = model->getPrintName();
+    std::list<CachedFit>::iterator it;
+    for (it = fitCache.begin(); it != fitCache.end(); it++) {
+        if (it->name == name) {
+            delete it->table;
+            fitCache.erase(it);
+            return;
+        }
+    }
+}
+
+void ManagerBase::clearFitCache() {
+    std::list<CachedFit>::iterator it;
+    for (it = fitCache.begin(); it != fitCache.end(); it++) {
+        delete it->table;
+    }
+    fitCache.clear();
+}
+
 void ManagerBase::makeOrthoExpansion(Relation *rel, Table *outTable) {
+    //-- with a small state space, each state just takes the value of its relation cell,
+    //-- and the states come out already sorted.
+    if (!rel->isStateBased() && useDenseTables()) {
+        DenseTable dense(varList);
+        long long cells;
+        unsigned int *cellMap = dense.makeCellMap(rel, &cells);
+        if (cellMap) {
+            double *relValues = new double[cells]();
+            Table *relTable = rel->getTable();
+            for (long long i = 0; i < relTable->getTupleCount(); i++) {
+                relValues[dense.cellOf(rel, relTable->getKey(i))] = relTable->getValue(i);
+            }
+            double *values = dense.getValues();
+            for (long long s = 0; s < dense.getStateCount(); s++) {
+                values[s] = relValues[cellMap[s]];
+            }
+            dense.toTable(outTable);
+            outTable->normalize();
+            delete[] relValues;
+            delete[] cellMap;
+            return;
+        }
+    }
     //-- get an array of the variable indices which don't occur in the relation.
     int varCount = rel->getVariableList()->getVarCount();
     int missingVars[varCount];
@@ -861,7 +1197,10 @@ double ManagerBase::computeH(Model *model, HMethod method, int SB) {
     if (loops) {
         h = model->getAttribute(ATTRIBUTE_FIT_H);
         if (h < 0) {
-            makeFitTable(model);
+            if (method == JUNCTION_TREE)
+                makeFitTableJunctionTree(model);
+            else
+                makeFitTable(model);
             h = ocEntropy(fitTable1);
             model->setAttribute(ATTRIBUTE_FIT_H, h);
             model->setAttribute(ATTRIBUTE_H, h);
@@ -1305,9 +1644,9 @@ Model *ManagerBase::makeModel(const char *name, bool makeProject) {
     delete[] relname;
 
     //-- put it in the cache; return the cached one if present
-    if (!modelCache->addModel(model)) {
+    Model *cachedModel = modelCache->findOrAddModel(model);
+    if (cachedModel != model) {
         //-- already exists in cache; return that one
-        Model *cachedModel = modelCache->findModel(model->getPrintName());
         delete model;
         model = cachedModel;
     }
@@ -1373,9 +1712,9 @@ Model *ManagerBase::makeSbModel(const char *name, bool makeProject) {
     model->completeSbModel();
 
     //-- put it in the cache; return the cached one if present
-    if (!modelCache->addModel(model)) {
+    Model *cachedModel = modelCache->findOrAddModel(model);
+    if (cachedModel != model) {
         //-- already exists in cache; return that one
-        Model *cachedModel = modelCache->findModel(model->getPrintName());
         delete model;
         model = cachedModel;
     }
@@ -1402,6 +1741,11 @@ void ManagerBase::printSizes() {
     printf("Rel-cache: %ld; ", size);
     size = modelCache->size();
     printf("Model cache: %ld; ", size);
+    printf("Projections: %lld (%lld from cached supersets), %lld source tuples; ", projectionCount,
+            projectionSupersetHits, projectionSourceTuples);
+    printf("Tables released: %lld; ", tablesReleased);
+    if (diskCache)
+        printf("Projections from disk: %lld; ", diskCache->getHits());
     //	relCache->dump();
     modelCache->dump();
 }
@@ -1454,6 +1798,7 @@ bool ManagerBase::makeFitTableAlgebraic(Model* model) {
     
     long long inSize = inputData->getTupleCount();
     Table *algTable = new Table(keysize, inSize);
+    algTable->beginHashed();
 
     // for every tuple in training data:
     for (long long ti = 0; ti < inSize; ti++) {
@@ -1478,7 +1823,7 @@ bool ManagerBase::makeFitTableAlgebraic(Model* model) {
 
     if (testData) { fitTestAlgebraic(model, algTable, missingCard, fitIs); }
 
-    algTable->sort();
+    algTable->finalize();
     if (fitTable1) delete fitTable1;
     fitTable1 = algTable;
  
@@ -1504,11 +1849,25 @@ bool ManagerBase::makeFitTableIPF(Model* model) {
             stateSpaceSize = 1000000;
         projTable = new Table(keysize, stateSpaceSize);
     }
+    //-- this may fit the progenitor first, so it comes before the work tables are reset
+    Model *warmSource = NULL;
+    Table *warmStart = model->isStateBased() ? NULL : findWarmStart(model, warmSource);
+    double coldIterations = -1;
+    if (warmStart) {
+        //-- with ipf-warm-check, fit from the usual start as well, to measure the savings
+        double check;
+        if (getOptionFloat("ipf-warm-check", NULL, &check) && check > 0) {
+            warmStartPaused = true;
+            makeFitTableIPF(model);
+            warmStartPaused = false;
+            coldIterations = model->getAttribute(ATTRIBUTE_IPF_ITERATIONS);
+        }
+    }
+
     fitTable1->reset(keysize);
     fitTable2->reset(keysize);
     projTable->reset(keysize);
     KeySegment *key = new KeySegment[keysize];
-    int k;
     double error = 0;
 
     makeProjections(model);
@@ -1534,8 +1893,6 @@ bool ManagerBase::makeFitTableIPF(Model* model) {
             expsize = newexpsize;
         }
     }
-    makeOrthoExpansion(relList[startRel], fitTable1);
-
     // configurable fitting parameters:  convergence error. This is approximately in units of samples.
     // if initial data was probabilities, an artificial scale of 1000 is used.
     double delta2;
@@ -1557,63 +1914,469 @@ bool ManagerBase::makeFitTableIPF(Model* model) {
     Relation *rel;
     Table *table;
     KeySegment *mask;
-    for (iter = 0; iter < maxiter; iter++) {
-        error = 0.0; // absolute difference between original projection and computed values
-        for (r = 0; r < relCount; r++) {
-            rel = relList[r];
-            table = tableList[r];
-            mask = maskList[r];
-            // create a projection of the computed data, based on the variables in the relation
-            projTable->reset(keysize);
-            makeProjection(fitTable1, projTable, rel);
-            // for each tuple in fitTable1, create a scaled tuple in fitTable2, scaled by the
-            // ratio of the projection from the input data, and the computed projection
-            // from the previous iteration.  In any cases where the input marginal is
-            // zero, or where the computed marginal is zero, skip this tuple (equivalent
-            // to setting it to zero, but conserves space).
-            tupleCount = fitTable1->getTupleCount();
-            fitTable2->reset(keysize);
-            for (i = 0; i < tupleCount; i++) {
-                newValue = 0.0;
-                fitTable1->copyKey(i, key);
-                value = fitTable1->getValue(i);
-                for (k = 0; k < keysize; k++)
-                    key[k] |= mask[k];
-                j = table->indexOf(key);
-                if (j >= 0) {
-                    relValue = table->getValue(j);
-                    if (relValue > DBL_EPSILON) {
-                        j = projTable->indexOf(key);
-                        if (j >= 0) {
-                            projValue = projTable->getValue(j);
-                            if (projValue > DBL_EPSILON) {
-                                newValue = value * relValue / projValue;
+    //-- with ipf-trace, the error of each pass is printed after the fit
+    double traceOption;
+    std::vector<double> trace;
+    std::vector<double> *tracePtr = getOptionFloat("ipf-trace", NULL, &traceOption) && traceOption > 0 ? &trace : NULL;
+    clock_t startClock = clock();
+    if (!model->isStateBased()) {
+        //-- the dense fit declines relations it can't map, which get the sparse fit instead
+        if (!useDenseTables()
+                || !denseIPF(relList, relCount, startRel, warmStart, delta2, maxiter, iter, error, tracePtr)) {
+            if (warmStart)
+                fitTable1->copy(warmStart);
+            else
+                makeOrthoExpansion(relList[startRel], fitTable1);
+            indexedIPF(relList, relCount, delta2, maxiter, iter, error, tracePtr);
+        }
+    } else {
+        //-- state-based projections spread leftover mass over unconstrained cells, so
+        //-- these are recomputed through makeProjection on every pass
+        makeOrthoExpansion(relList[startRel], fitTable1);
+        for (iter = 0; iter < maxiter; iter++) {
+            error = 0.0; // absolute difference between original projection and computed values
+            for (r = 0; r < relCount; r++) {
+                rel = relList[r];
+                table = tableList[r];
+                mask = maskList[r];
+                // create a projection of the computed data, based on the variables in the relation
+                projTable->reset(keysize);
+                makeProjection(fitTable1, projTable, rel);
+                // for each tuple in fitTable1, create a scaled tuple in fitTable2, scaled by the
+                // ratio of the projection from the input data, and the computed projection
+                // from the previous iteration.  In any cases where the input marginal is
+                // zero, or where the computed marginal is zero, skip this tuple (equivalent
+                // to setting it to zero, but conserves space).
+                tupleCount = fitTable1->getTupleCount();
+                fitTable2->reset(keysize);
+                for (i = 0; i < tupleCount; i++) {
+                    newValue = 0.0;
+                    value = fitTable1->getValue(i);
+                    Key::applyMask(key, fitTable1->getKey(i), mask, keysize);
+                    j = table->indexOf(key);
+                    if (j >= 0) {
+                        relValue = table->getValue(j);
+                        if (relValue > DBL_EPSILON) {
+                            j = projTable->indexOf(key);
+                            if (j >= 0) {
+                                projValue = projTable->getValue(j);
+                                if (projValue > DBL_EPSILON) {
+                                    newValue = value * relValue / projValue;
+                                }
+                                error = fmax(error, fabs(relValue - projValue));
+                            } else {
+                                error = fmax(error, relValue);
                             }
-                            error = fmax(error, fabs(relValue - projValue));
-                        } else {
-                            error = fmax(error, relValue);
                         }
                     }
+                    if (newValue > DBL_EPSILON) {
+                        fitTable2->addTuple(fitTable1->getKey(i), newValue);
+                    }
                 }
-                if (newValue > DBL_EPSILON) {
-                    fitTable1->copyKey(i, key);
-                    fitTable2->addTuple(key, newValue);
-                }
+                Table *ftswap = fitTable1;        // swap fitTable1 and fitTable2 for next pass
+                fitTable1 = fitTable2;
+                fitTable2 = ftswap;
             }
-            Table *ftswap = fitTable1;        // swap fitTable1 and fitTable2 for next pass
-            fitTable1 = fitTable2;
-            fitTable2 = ftswap;
+            if (tracePtr)
+                trace.push_back(error);
+            if (error < delta2)         // check convergence
+                break;
         }
-        if (error < delta2)         // check convergence
-            break;
     }
+    double seconds = (double) (clock() - startClock) / CLOCKS_PER_SEC;
     fitTable1->sort();
+    //-- iter is the index of the converging pass, or maxiter if it never converged
+    double passes = iter < maxiter ? iter + 1 : iter;
     model->setAttribute(ATTRIBUTE_IPF_ITERATIONS, (double) iter);
     model->setAttribute(ATTRIBUTE_IPF_ERROR, error);
+    model->setAttribute(ATTRIBUTE_IPF_RATE, seconds > 0 ? passes / seconds : 0);
+    if (tracePtr) {
+        //-- errors are shown in samples, the units of ipf-maxdev
+        double scale = sampleSize > 0 ? sampleSize : 1000;
+        printf("IPF trace %s: %d passes, max deviation", model->getPrintName(), (int) trace.size());
+        for (size_t t = 0; t < trace.size(); t++) {
+            printf(" %.6g", trace[t] * scale);
+        }
+        printf("\n");
+    }
+    model->setAttribute(ATTRIBUTE_IPF_WARM_START, warmStart ? (double) warmSource->getID() : -1.0);
+    if (coldIterations >= 0)
+        model->setAttribute(ATTRIBUTE_IPF_SAVED, coldIterations - iter);
+    if (!model->isStateBased() && !warmStartPaused)
+        saveWarmStart(model);
     delete[] key;
     return true;
 }
 
+/**
+ * ipfPasses - the iteration shared by denseIPF, indexedIPF and the junction tree fit. values holds one entry per
+ * tuple (or state) of the fit; cellMaps[r][i] is the cell of tuple i in relation r, or
+ * IPF_NO_CELL if the relation has no matching tuple. Zero-valued entries stand for tuples
+ * the table-based loop would have dropped, so they are skipped, which keeps iteration
+ * counts, errors and values identical to it.
+ *
+ * With more than one thread, each relation's tuples are grouped by cell once (a counting
+ * sort that keeps tuple order within a cell), and threads own disjoint ranges of cells for
+ * the marginal sums. Each cell is therefore summed in ascending tuple order no matter how
+ * many threads run, so results are bit-identical across thread counts. The scaling step
+ * is independent per tuple; the per-thread maximum errors are combined in thread order.
+ *
+ * If accelerate is set, passes are extrapolated by an IPFExtrapolator. If trace is given,
+ * the error of each pass is appended to it.
+ */
+static const unsigned int IPF_NO_CELL = 0xffffffff;
+static const long long IPF_PARALLEL_MIN = 32768; // smaller fits run on one thread
+static const long long IPF_SUM_BLOCK = 65536; // extrapolation sums are combined in fixed blocks
+
+/**
+ * IPFExtrapolator - Aitken-style acceleration of IPF passes (the ipf-accelerate option).
+ * IPF converges linearly, so near the solution the change in log(value) from one pass to
+ * the next shrinks by a nearly constant ratio. After three plain passes the ratio is
+ * estimated from the last two steps, and the values are moved to where the geometric
+ * series of remaining steps would take them. Zero values stay zero.
+ *
+ * The pass after an extrapolation is checked: if its error is worse than that of the
+ * pass before, the extrapolation is undone, and the number of plain passes before the
+ * next attempt is doubled, so where extrapolation doesn't help the cost falls away to
+ * that of plain IPF. Sums are formed over fixed blocks in
+ * block order, so results don't depend on the number of threads.
+ *
+ * The fit still stops only once a plain pass meets ipf-maxdev, but it reaches that point
+ * along a different path, so its values (and the statistics printed from them) differ
+ * from plain IPF's by up to about the tolerance; they agree as ipf-maxdev is tightened.
+ */
+class IPFExtrapolator {
+    public:
+        IPFExtrapolator(long long count, int threads) :
+                count(count), threads(threads), stored(0), pending(false), backoff(0), wait(0), lastError(0) {
+            history[0] = new double[count];
+            history[1] = new double[count];
+        }
+        ~IPFExtrapolator() {
+            delete[] history[0];
+            delete[] history[1];
+        }
+
+        //-- called with the values and error after each pass which didn't converge
+        void update(double *values, double error) {
+            if (pending) {
+                pending = false;
+                if (error > lastError) {
+                    //-- history[0] holds the values from before the extrapolation
+                    memcpy(values, history[0], count * sizeof(double));
+                    backoff = backoff ? backoff * 2 : 3;
+                    wait = backoff;
+                    stored = 0;
+                    return;
+                }
+                stored = 0;
+            }
+            if (wait > 0) {
+                wait--;
+                return;
+            }
+            if (stored < 2) {
+                memcpy(history[stored++], values, count * sizeof(double));
+                return;
+            }
+            stored = 0;
+            if (extrapolate(values)) {
+                pending = true;
+                lastError = error;
+            }
+        }
+
+        //-- true if the last update extrapolated, so the next pass is the first after it
+        bool extrapolated() {
+            return pending;
+        }
+
+    private:
+        static constexpr double MAX_RATIO = 0.95;
+
+        bool extrapolate(double *values) {
+            double *older = history[0], *old = history[1];
+            long long blocks = (count + IPF_SUM_BLOCK - 1) / IPF_SUM_BLOCK;
+            std::vector<double> cross(blocks), square(blocks), total(blocks), newTotal(blocks);
+            parallelFor(threads, blocks, [&](long long begin, long long end, int) {
+                for (long long b = begin; b < end; b++) {
+                    double c = 0, s = 0;
+                    for (long long i = b * IPF_SUM_BLOCK; i < count && i < (b + 1) * IPF_SUM_BLOCK; i++) {
+                        if (values[i] > 0 && old[i] > 0 && older[i] > 0) {
+                            double d1 = log(old[i] / older[i]);
+                            double d2 = log(values[i] / old[i]);
+                            c += d1 * d2;
+                            s += d1 * d1;
+                        }
+                    }
+                    cross[b] = c;
+                    square[b] = s;
+                }
+            });
+            double c = 0, s = 0;
+            for (long long b = 0; b < blocks; b++) {
+                c += cross[b];
+                s += square[b];
+            }
+            double ratio = s > 0 ? c / s : 0;
+            if (!(ratio > 0))
+                return false;
+            if (ratio > MAX_RATIO)
+                ratio = MAX_RATIO;
+            double factor = ratio / (1 - ratio);
+
+            //-- keep the current values to fall back on, then extrapolate and rescale to
+            //-- the same total
+            memcpy(older, values, count * sizeof(double));
+            parallelFor(threads, blocks, [&](long long begin, long long end, int) {
+                for (long long b = begin; b < end; b++) {
+                    double t = 0, nt = 0;
+                    for (long long i = b * IPF_SUM_BLOCK; i < count && i < (b + 1) * IPF_SUM_BLOCK; i++) {
+                        t += values[i];
+                        if (values[i] > 0 && old[i] > 0)
+                            values[i] *= pow(values[i] / old[i], factor);
+                        nt += values[i];
+                    }
+                    total[b] = t;
+                    newTotal[b] = nt;
+                }
+            });
+            double t = 0, nt = 0;
+            for (long long b = 0; b < blocks; b++) {
+                t += total[b];
+                nt += newTotal[b];
+            }
+            if (!(nt > 0) || !std::isfinite(nt)) {
+                memcpy(values, older, count * sizeof(double));
+                return false;
+            }
+            double scale = t / nt;
+            parallelFor(threads, count, [&](long long begin, long long end, int) {
+                for (long long i = begin; i < end; i++)
+                    values[i] *= scale;
+            });
+            return true;
+        }
+
+        long long count;
+        int threads;
+        double *history[2]; // the last plain passes, oldest first
+        int stored; // how many of history are valid
+        bool pending; // the last update extrapolated; check the next pass
+        int backoff; // plain passes to wait after the next failure
+        int wait; // plain passes left to wait before storing history again
+        double lastError;
+};
+
+void ManagerBase::ipfPasses(double *values, long long count, int relCount, unsigned int **cellMaps,
+        double **relValues, long long *cellCounts, double delta2, double maxiter, int threads,
+        int &iter, double &error, bool accelerate, std::vector<double> *trace) {
+    if (count < IPF_PARALLEL_MIN)
+        threads = 1;
+    double *projValues[relCount];
+    unsigned int *cellStart[relCount]; // for threads > 1: tuples of cell c are
+    unsigned int *cellTuples[relCount]; // cellTuples[cellStart[c] .. cellStart[c+1]-1]
+    for (int r = 0; r < relCount; r++) {
+        projValues[r] = new double[cellCounts[r]];
+        cellStart[r] = cellTuples[r] = NULL;
+        if (threads == 1)
+            continue;
+        unsigned int *cellMap = cellMaps[r];
+        unsigned int *start = cellStart[r] = new unsigned int[cellCounts[r] + 1]();
+        unsigned int *tuples = cellTuples[r] = new unsigned int[count];
+        for (long long i = 0; i < count; i++) {
+            if (cellMap[i] != IPF_NO_CELL)
+                start[cellMap[i] + 1]++;
+        }
+        for (long long c = 0; c < cellCounts[r]; c++)
+            start[c + 1] += start[c];
+        unsigned int *next = new unsigned int[cellCounts[r]];
+        memcpy(next, start, cellCounts[r] * sizeof(unsigned int));
+        for (long long i = 0; i < count; i++) {
+            if (cellMap[i] != IPF_NO_CELL)
+                tuples[next[cellMap[i]]++] = (unsigned int) i;
+        }
+        delete[] next;
+    }
+    double threadError[threads];
+    IPFExtrapolator *extrapolator = accelerate ? new IPFExtrapolator(count, threads) : NULL;
+
+    for (iter = 0; iter < maxiter; iter++) {
+        error = 0.0;
+        for (int r = 0; r < relCount; r++) {
+            unsigned int *cellMap = cellMaps[r];
+            double *relValue = relValues[r];
+            double *projValue = projValues[r];
+            if (threads == 1) {
+                memset(projValue, 0, cellCounts[r] * sizeof(double));
+                for (long long i = 0; i < count; i++) {
+                    if (cellMap[i] != IPF_NO_CELL)
+                        projValue[cellMap[i]] += values[i];
+                }
+            } else {
+                unsigned int *start = cellStart[r];
+                unsigned int *tuples = cellTuples[r];
+                parallelFor(threads, cellCounts[r], [&](long long begin, long long end, int) {
+                    for (long long c = begin; c < end; c++) {
+                        double sum = 0.0;
+                        for (unsigned int k = start[c]; k < start[c + 1]; k++)
+                            sum += values[tuples[k]];
+                        projValue[c] = sum;
+                    }
+                });
+            }
+            memset(threadError, 0, sizeof(threadError));
+            parallelFor(threads, count, [&](long long begin, long long end, int thread) {
+                double err = 0.0;
+                for (long long i = begin; i < end; i++) {
+                    if (values[i] == 0.0)
+                        continue;
+                    unsigned int c = cellMap[i];
+                    double newValue = 0.0;
+                    if (c != IPF_NO_CELL && relValue[c] > DBL_EPSILON) {
+                        if (projValue[c] > DBL_EPSILON) {
+                            newValue = values[i] * relValue[c] / projValue[c];
+                        }
+                        err = fmax(err, fabs(relValue[c] - projValue[c]));
+                    }
+                    values[i] = newValue > DBL_EPSILON ? newValue : 0.0;
+                }
+                threadError[thread] = err;
+            });
+            for (int t = 0; t < threads; t++)
+                error = fmax(error, threadError[t]);
+        }
+        if (trace)
+            trace->push_back(error);
+        //-- a pass measures the values it started from, so after an extrapolation one more
+        //-- plain pass has to meet the limit before the fit stops
+        if (error < delta2 && !(extrapolator && extrapolator->extrapolated()))
+            break;
+        if (extrapolator)
+            extrapolator->update(values, error);
+    }
+    delete extrapolator;
+
+    for (int r = 0; r < relCount; r++) {
+        delete[] projValues[r];
+        delete[] cellStart[r];
+        delete[] cellTuples[r];
+    }
+}
+
+/**
+ * denseIPF - the IPF iteration of makeFitTableIPF, run over flat arrays covering the whole
+ * state space. Each relation gets a map from state to relation cell, so computing the
+ * marginal and scaling the fit are both single linear passes. A state holds a tuple of the
+ * sparse fit exactly when its value is nonzero, so the iteration count, error and fitted
+ * values match the sparse version. The result is left, sorted, in fitTable1. If warmStart
+ * is given, the iteration starts from it instead of from the expansion of relList[startRel].
+ * Returns false, having done nothing, if a relation can't be mapped onto the dense table.
+ */
+bool ManagerBase::denseIPF(Relation **relList, int relCount, int startRel, Table *warmStart, double delta2,
+        double maxiter, int &iter, double &error, std::vector<double> *trace) {
+    DenseTable fit(varList);
+    long long stateCount = fit.getStateCount();
+    double *values = fit.getValues();
+    unsigned int *cellMaps[relCount];
+    double *relValues[relCount];
+    long long cellCounts[relCount];
+    for (int r = 0; r < relCount; r++) {
+        cellMaps[r] = fit.makeCellMap(relList[r], &cellCounts[r]);
+        if (cellMaps[r] == NULL) {
+            for (int q = 0; q < r; q++) {
+                delete[] cellMaps[q];
+                delete[] relValues[q];
+            }
+            return false;
+        }
+        relValues[r] = new double[cellCounts[r]]();
+        Table *table = relList[r]->getTable();
+        for (long long i = 0; i < table->getTupleCount(); i++) {
+            relValues[r][fit.cellOf(relList[r], table->getKey(i))] = table->getValue(i);
+        }
+    }
+
+    if (warmStart) {
+        fit.addTable(warmStart);
+    } else {
+        //-- orthogonal expansion of the starting relation, normalized
+        double total = 0;
+        for (long long s = 0; s < stateCount; s++) {
+            values[s] = relValues[startRel][cellMaps[startRel][s]];
+            total += values[s];
+        }
+        for (long long s = 0; s < stateCount; s++) {
+            values[s] /= total;
+        }
+    }
+
+    ipfPasses(values, stateCount, relCount, cellMaps, relValues, cellCounts, delta2, maxiter,
+            getIPFThreads(), iter, error, useIPFAcceleration(), trace);
+    fit.toTable(fitTable1);
+
+    for (int r = 0; r < relCount; r++) {
+        delete[] cellMaps[r];
+        delete[] relValues[r];
+    }
+    return true;
+}
+
+/**
+ * indexedIPF - IPF over the tuples of the orthogonal expansion in fitTable1. The support
+ * never grows, and a tuple dropped by the sparse algorithm is just a zero here, so each
+ * tuple's marginal cell (its index in the relation's table, or IPF_NO_CELL if the relation
+ * has no such tuple) is looked up once per fit. Every pass is then a gather into the
+ * marginal array and a scale of the values, with no key handling or searching.
+ */
+void ManagerBase::indexedIPF(Relation **relList, int relCount, double delta2, double maxiter, int &iter,
+        double &error, std::vector<double> *trace) {
+    long long tupleCount = fitTable1->getTupleCount();
+    double *values = new double[tupleCount];
+    unsigned int *cellMaps[relCount];
+    double *relValues[relCount];
+    long long cellCounts[relCount];
+    KeySegment *key = new KeySegment[keysize];
+    for (long long i = 0; i < tupleCount; i++) {
+        values[i] = fitTable1->getValue(i);
+    }
+    for (int r = 0; r < relCount; r++) {
+        Table *table = relList[r]->getTable();
+        KeySegment *mask = relList[r]->getMask();
+        cellCounts[r] = table->getTupleCount();
+        cellMaps[r] = new unsigned int[tupleCount];
+        relValues[r] = new double[cellCounts[r]];
+        for (long long c = 0; c < cellCounts[r]; c++) {
+            relValues[r][c] = table->getValue(c);
+        }
+        for (long long i = 0; i < tupleCount; i++) {
+            Key::applyMask(key, fitTable1->getKey(i), mask, keysize);
+            long long j = table->indexOf(key);
+            cellMaps[r][i] = j >= 0 ? (unsigned int) j : IPF_NO_CELL;
+        }
+    }
+
+    ipfPasses(values, tupleCount, relCount, cellMaps, relValues, cellCounts, delta2, maxiter,
+            getIPFThreads(), iter, error, useIPFAcceleration(), trace);
+
+    //-- write back the surviving tuples; the support is sorted, so the result is too
+    fitTable2->reset(keysize);
+    for (long long i = 0; i < tupleCount; i++) {
+        if (values[i] > 0.0)
+            fitTable2->addTuple(fitTable1->getKey(i), values[i]);
+    }
+    Table *ftswap = fitTable1;
+    fitTable1 = fitTable2;
+    fitTable2 = ftswap;
+
+    for (int r = 0; r < relCount; r++) {
+        delete[] cellMaps[r];
+        delete[] relValues[r];
+    }
+    delete[] values;
+    delete[] key;
+}
+
 bool ManagerBase::makeFitTable(Model *model) {
     
     if (model == nullptr) { return false; }
@@ -1625,6 +2388,8 @@ bool ManagerBase::makeFitTable(Model *model) {
           && !model->isStateBased() 
           && !getVariableList()->isDirected()) 
         { return makeFitTableAlgebraic(model); }
+    else if (!model->isStateBased() && useJunctionTree())
+        { return makeFitTableJunctionTree(model); }
     else 
         { return makeFitTableIPF(model); }
 }
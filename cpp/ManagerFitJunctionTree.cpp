@@ -0,0 +1,434 @@
+/*
+ * Copyright © 1990 The Portland State University OCCAM Project Team
+ * [This program is licensed under the GPL version 3 or later.]
+ * Please see the file LICENSE in the source
+ * distribution of this software for license terms.
+ */
+
+/**
+ * makeFitTableJunctionTree - exact fitting for models with loops, by decomposition.
+ *
+ * The model's interaction graph (variables joined when they share a relation) is
+ * triangulated by eliminating variables in min-fill order, and the cliques of the
+ * triangulated graph are joined into a junction tree. Wherever two neighbouring cliques
+ * are separated by a set of variables which lies within one of the model's relations, the
+ * fit decomposes there: the separator's fitted marginal is the observed one, so the fit is
+ * the product of the two sides' fits divided by the separator marginal. Cliques joined by
+ * any other separator (one made of fill-in edges) are merged into a single component.
+ *
+ * Each component is fit on its own variables only. A component which is itself a relation
+ * of the model just takes the observed marginal; any other contains a loop, and is fit by
+ * IPF over a dense table of its own states, using the model's relations inside it plus its
+ * separators (which the full fit matches anyway). The component fits are then joined along
+ * the tree. The IPF work is thus confined to the loops, over state spaces the size of the
+ * loop's variables rather than of the whole data.
+ *
+ * The triangulated model is loopless, so this is the same product of marginals that
+ * makeFitTableAlgebraic forms from computeIntersectLevels. But that works from the input
+ * tuples, while a fit for H needs every nonzero state, so the product is formed here by
+ * joining the component tables on their separators.
+ */
+
+#include "DenseTable.h"
+#include "Key.h"
+#include "ManagerBase.h"
+#include "Model.h"
+#include "Relation.h"
+#include "Table.h"
+#include "VariableList.h"
+#include <float.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+using std::vector;
+
+//-- true if every variable of vars is in rel
+static bool relationContains(Relation *rel, const vector<int> &vars) {
+    for (size_t i = 0; i < vars.size(); i++) {
+        if (rel->findVariable(vars[i]) < 0)
+            return false;
+    }
+    return true;
+}
+
+//-- add rel to a list of relations, unless it is already there
+static void addRelation(vector<Relation*> &rels, Relation *rel) {
+    for (size_t i = 0; i < rels.size(); i++) {
+        if (rels[i] == rel) return;
+    }
+    rels.push_back(rel);
+}
+
+static vector<int> intersection(const vector<int> &a, const vector<int> &b) {
+    vector<int> result;
+    size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size()) {
+        if (a[i] < b[j]) i++;
+        else if (b[j] < a[i]) j++;
+        else {
+            result.push_back(a[i]);
+            i++;
+            j++;
+        }
+    }
+    return result;
+}
+
+static vector<int> merge(const vector<int> &a, const vector<int> &b) {
+    vector<int> result;
+    size_t i = 0, j = 0;
+    while (i < a.size() || j < b.size()) {
+        if (j >= b.size() || (i < a.size() && a[i] < b[j])) result.push_back(a[i++]);
+        else if (i >= a.size() || b[j] < a[i]) result.push_back(b[j++]);
+        else {
+            result.push_back(a[i]);
+            i++;
+            j++;
+        }
+    }
+    return result;
+}
+
+/**
+ * triangulate - eliminate the variables in min-fill order (ties to the fewest neighbours),
+ * returning the maximal cliques of the triangulated graph, each as a sorted variable list.
+ * A clique is skipped if an earlier one contains it; a later one never contains an earlier
+ * one, since the earlier holds its eliminated variable.
+ */
+static vector<vector<int> > triangulate(vector<vector<bool> > &adj) {
+    int varCount = adj.size();
+    vector<bool> eliminated(varCount, false);
+    vector<vector<int> > cliques;
+    for (int step = 0; step < varCount; step++) {
+        int best = -1;
+        long bestFill = 0, bestDegree = 0;
+        for (int v = 0; v < varCount; v++) {
+            if (eliminated[v]) continue;
+            vector<int> nbrs;
+            for (int u = 0; u < varCount; u++) {
+                if (u != v && !eliminated[u] && adj[v][u]) nbrs.push_back(u);
+            }
+            long fill = 0;
+            for (size_t i = 0; i < nbrs.size(); i++) {
+                for (size_t j = i + 1; j < nbrs.size(); j++) {
+                    if (!adj[nbrs[i]][nbrs[j]]) fill++;
+                }
+            }
+            if (best < 0 || fill < bestFill || (fill == bestFill && (long) nbrs.size() < bestDegree)) {
+                best = v;
+                bestFill = fill;
+                bestDegree = nbrs.size();
+            }
+        }
+        vector<int> clique;
+        for (int u = 0; u < varCount; u++) {
+            if (u == best || (!eliminated[u] && adj[best][u])) clique.push_back(u);
+        }
+        for (size_t i = 0; i < clique.size(); i++) {
+            for (size_t j = 0; j < clique.size(); j++) {
+                if (i != j) adj[clique[i]][clique[j]] = true;
+            }
+        }
+        eliminated[best] = true;
+        bool contained = false;
+        for (size_t c = 0; c < cliques.size() && !contained; c++) {
+            contained = intersection(cliques[c], clique).size() == clique.size();
+        }
+        if (!contained) cliques.push_back(clique);
+    }
+    return cliques;
+}
+
+/**
+ * joinTables - the fit so far (keys with DONT_CARE for variables not yet covered) joined
+ * with a component's fit on their separator. Where both keys are set they agree, and
+ * DONT_CARE fields are all ones, so the joined key is just the bitwise and of the two.
+ */
+static Table *joinTables(Table *left, Table *right, Relation *sep, int keysize) {
+    KeySegment key[keysize];
+    KeySegment sepMask[keysize];
+    Table *sepTable = NULL;
+    if (sep) {
+        memcpy(sepMask, sep->getMask(), keysize * sizeof(KeySegment));
+        sepTable = sep->getTable();
+    } else {
+        memset(sepMask, 0xff, keysize * sizeof(KeySegment));
+    }
+
+    //-- group the right-hand tuples by their separator key
+    long long rightCount = right->getTupleCount();
+    Table *groups = new Table(keysize, rightCount + 1);
+    groups->beginHashed();
+    long long *groupOf = new long long[rightCount];
+    for (long long i = 0; i < rightCount; i++) {
+        Key::applyMask(key, right->getKey(i), sepMask, keysize);
+        long long g = groups->indexOf(key);
+        if (g < 0) {
+            g = groups->getTupleCount();
+            groups->addTuple(key, 0);
+        }
+        groupOf[i] = g;
+    }
+    long long groupCount = groups->getTupleCount();
+    long long *groupStart = new long long[groupCount + 1]();
+    long long *members = new long long[rightCount];
+    for (long long i = 0; i < rightCount; i++) {
+        groupStart[groupOf[i] + 1]++;
+    }
+    for (long long g = 0; g < groupCount; g++) {
+        groupStart[g + 1] += groupStart[g];
+    }
+    long long *fill = new long long[groupCount];
+    memcpy(fill, groupStart, groupCount * sizeof(long long));
+    for (long long i = 0; i < rightCount; i++) {
+        members[fill[groupOf[i]]++] = i;
+    }
+
+    long long leftCount = left->getTupleCount();
+    Table *result = new Table(keysize, leftCount + 1);
+    for (long long i = 0; i < leftCount; i++) {
+        KeySegment *leftKey = left->getKey(i);
+        Key::applyMask(key, leftKey, sepMask, keysize);
+        long long g = groups->indexOf(key);
+        if (g < 0) continue;
+        double sepValue = 1.0;
+        if (sepTable) {
+            long long j = sepTable->indexOf(key);
+            if (j < 0) continue;
+            sepValue = sepTable->getValue(j);
+            if (sepValue <= DBL_EPSILON) continue;
+        }
+        double leftValue = left->getValue(i) / sepValue;
+        for (long long m = groupStart[g]; m < groupStart[g + 1]; m++) {
+            KeySegment *rightKey = right->getKey(members[m]);
+            double value = leftValue * right->getValue(members[m]);
+            if (value <= 0.0) continue;
+            for (int k = 0; k < keysize; k++) {
+                key[k] = leftKey[k] & rightKey[k];
+            }
+            result->addTuple(key, value);
+        }
+    }
+    delete groups;
+    delete[] groupOf;
+    delete[] groupStart;
+    delete[] members;
+    delete[] fill;
+    return result;
+}
+
+bool ManagerBase::junctionTreeFallback(Model *model, const char *reason) {
+    if (!junctionTreeWarned) {
+        printf("WARNING: fit-method junction-tree can't fit model %s (%s); using IPF instead."
+                " Further models are not reported.\n", model->getPrintName(), reason);
+        junctionTreeWarned = true;
+    }
+    return makeFitTableIPF(model);
+}
+
+bool ManagerBase::makeFitTableJunctionTree(Model *model) {
+    if (model->isStateBased())
+        return makeFitTableIPF(model);
+    makeProjections(model);
+    int relCount = model->getRelationCount();
+    int varCount = varList->getVarCount();
+
+    //-- interaction graph of the model; every variable must be in some relation
+    vector<vector<bool> > adj(varCount, vector<bool>(varCount, false));
+    vector<bool> covered(varCount, false);
+    for (int r = 0; r < relCount; r++) {
+        Relation *rel = model->getRelation(r);
+        for (int i = 0; i < rel->getVariableCount(); i++) {
+            int vi = rel->getVariable(i);
+            covered[vi] = true;
+            for (int j = 0; j < rel->getVariableCount(); j++) {
+                adj[vi][rel->getVariable(j)] = true;
+            }
+        }
+    }
+    for (int v = 0; v < varCount; v++) {
+        if (!covered[v])
+            return junctionTreeFallback(model, "a variable is in no relation");
+    }
+
+    //-- junction tree over the cliques: a maximum spanning tree on separator size, built
+    //-- by Prim's algorithm, so each clique's parent comes before it in tree order
+    vector<vector<int> > cliques = triangulate(adj);
+    int cliqueCount = cliques.size();
+    vector<int> order, parent(cliqueCount, -1);
+    vector<bool> inTree(cliqueCount, false);
+    vector<long> bestSep(cliqueCount, -1);
+    int next = 0;
+    while (next >= 0) {
+        inTree[next] = true;
+        order.push_back(next);
+        for (int c = 0; c < cliqueCount; c++) {
+            if (inTree[c]) continue;
+            long sep = intersection(cliques[c], cliques[next]).size();
+            if (sep > bestSep[c]) {
+                bestSep[c] = sep;
+                parent[c] = next;
+            }
+        }
+        next = -1;
+        for (int c = 0; c < cliqueCount; c++) {
+            if (!inTree[c] && (next < 0 || bestSep[c] > bestSep[next]))
+                next = c;
+        }
+    }
+
+    //-- merge each clique into its parent's component unless their separator lies within
+    //-- a relation of the model. Components are numbered in tree order.
+    vector<int> compOf(cliqueCount, -1);
+    vector<vector<int> > compVars;
+    vector<vector<int> > compSep; // separator with the parent component
+    vector<int> compParent;
+    for (size_t o = 0; o < order.size(); o++) {
+        int c = order[o];
+        int p = parent[c];
+        vector<int> sep;
+        bool split = true;
+        if (p >= 0) {
+            sep = intersection(cliques[c], cliques[p]);
+            split = sep.empty();
+            for (int r = 0; r < relCount && !split; r++) {
+                split = relationContains(model->getRelation(r), sep);
+            }
+        }
+        if (!split) {
+            compOf[c] = compOf[p];
+            compVars[compOf[c]] = merge(compVars[compOf[c]], cliques[c]);
+        } else {
+            compOf[c] = compVars.size();
+            compVars.push_back(cliques[c]);
+            compSep.push_back(sep);
+            compParent.push_back(p >= 0 ? compOf[p] : -1);
+        }
+    }
+    int compCount = compVars.size();
+
+    double delta2;
+    getOptionFloat("ipf-maxdev", NULL, &delta2);
+    delta2 /= sampleSize > 0 ? sampleSize : 1000;
+    double maxiter;
+    getOptionFloat("ipf-maxit", NULL, &maxiter);
+    double threshold;
+    if (!getOptionFloat("dense-threshold", NULL, &threshold) || threshold > 4294967295.0)
+        threshold = 4294967295.0;
+
+    //-- the relations each component is fit to: the model's relations within it, and its
+    //-- separators with its parent and children.
+    vector<Relation*> sepRels(compCount, (Relation*) NULL);
+    vector<vector<Relation*> > compRels(compCount);
+    vector<Relation*> exact(compCount, (Relation*) NULL);
+    for (int k = 0; k < compCount; k++) {
+        if (!compSep[k].empty()) {
+            sepRels[k] = getRelation(&compSep[k][0], compSep[k].size(), true);
+            addRelation(compRels[k], sepRels[k]);
+            addRelation(compRels[compParent[k]], sepRels[k]);
+        }
+    }
+    for (int k = 0; k < compCount; k++) {
+        vector<bool> inComp(varCount, false);
+        for (size_t i = 0; i < compVars[k].size(); i++) {
+            inComp[compVars[k][i]] = true;
+        }
+        for (int r = 0; r < relCount; r++) {
+            Relation *rel = model->getRelation(r);
+            bool within = true;
+            for (int i = 0; i < rel->getVariableCount() && within; i++) {
+                within = inComp[rel->getVariable(i)];
+            }
+            if (!within) continue;
+            addRelation(compRels[k], rel);
+            if (rel->getVariableCount() == (int) compVars[k].size())
+                exact[k] = rel;
+        }
+        if (!exact[k]) {
+            double states = 1;
+            for (size_t i = 0; i < compVars[k].size(); i++) {
+                states *= varList->getVariable(compVars[k][i])->cardinality;
+            }
+            if (states > threshold)
+                return junctionTreeFallback(model, "a component's state space exceeds dense-threshold");
+        }
+    }
+
+    //-- fit each component, and join it to the fit of the components before it
+    clock_t startClock = clock();
+    int iter = 0;
+    double error = 0;
+    double passes = 0;
+    Table *fit = NULL;
+    for (int k = 0; k < compCount; k++) {
+        Table *compFit;
+        if (exact[k]) {
+            compFit = exact[k]->getTable();
+        } else {
+            Relation *compRel = getRelation(&compVars[k][0], compVars[k].size());
+            DenseTable local(varList, compRel);
+            int count = compRels[k].size();
+            unsigned int *cellMaps[count];
+            double *relValues[count];
+            long long cellCounts[count];
+            for (int r = 0; r < count; r++) {
+                cellMaps[r] = local.makeCellMap(compRels[k][r], &cellCounts[r]);
+                if (cellMaps[r] == NULL) {
+                    //-- the component's relations should lie within it; if not, fit by IPF
+                    for (int q = 0; q < r; q++) {
+                        delete[] cellMaps[q];
+                        delete[] relValues[q];
+                    }
+                    delete fit;
+                    return junctionTreeFallback(model, "a relation isn't within its component");
+                }
+                relValues[r] = new double[cellCounts[r]]();
+                Table *table = compRels[k][r]->getTable();
+                for (long long i = 0; i < table->getTupleCount(); i++) {
+                    relValues[r][local.cellOf(compRels[k][r], table->getKey(i))] = table->getValue(i);
+                }
+            }
+            long long stateCount = local.getStateCount();
+            double *values = local.getValues();
+            for (long long s = 0; s < stateCount; s++) {
+                values[s] = 1.0 / stateCount;
+            }
+            int compIter;
+            double compError;
+            ipfPasses(values, stateCount, count, cellMaps, relValues, cellCounts, delta2, maxiter,
+                    getIPFThreads(), compIter, compError, useIPFAcceleration());
+            iter = compIter > iter ? compIter : iter;
+            error = compError > error ? compError : error;
+            passes += compIter < maxiter ? compIter + 1 : compIter;
+            compFit = new Table(keysize, stateCount);
+            local.toTable(compFit);
+            for (int r = 0; r < count; r++) {
+                delete[] cellMaps[r];
+                delete[] relValues[r];
+            }
+        }
+        if (fit == NULL) {
+            fit = new Table(keysize, compFit->getTupleCount() + 1);
+            fit->copy(compFit);
+        } else {
+            Table *joined = joinTables(fit, compFit, sepRels[k], keysize);
+            delete fit;
+            fit = joined;
+        }
+        if (!exact[k])
+            delete compFit;
+    }
+    double seconds = (double) (clock() - startClock) / CLOCKS_PER_SEC;
+
+    fit->sort();
+    if (fitTable1) delete fitTable1;
+    fitTable1 = fit;
+    model->setAttribute(ATTRIBUTE_IPF_ITERATIONS, (double) iter);
+    model->setAttribute(ATTRIBUTE_IPF_ERROR, error);
+    model->setAttribute(ATTRIBUTE_IPF_RATE, seconds > 0 ? passes / seconds : 0);
+    //-- a child which falls back to makeFitTableIPF can start from this fit
+    saveWarmStart(model);
+    return true;
+}
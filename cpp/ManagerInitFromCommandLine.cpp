@@ -25,6 +25,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 bool ManagerBase::initFromCommandLine(int argc, char **argv) {
@@ -37,11 +38,15 @@ bool ManagerBase::initFromCommandLine(int argc, char **argv) {
     void *next = NULL;
     const char *fname;
     while (options->getOptionString("datafile", &next, &fname)) {
-        FILE *fd = fopen(fname, "r");
+        FILE *fd = ocOpenInput(fname);
         if (fd == NULL) {
             printf("ERROR: couldn't open %s\n", fname);
             return false;
-        } else if ((dataLines = ocReadFile(fd, options, &input, &test, &vars)) == 0) {
+        }
+        clock_t start = clock();
+        dataLines = ocReadFile(fd, options, &input, &test, &vars);
+        loadTime += (double) (clock() - start) / CLOCKS_PER_SEC;
+        if (dataLines == 0) {
             printf("ERROR: ocReadFile() failed for %s\n", fname);
             return false;
         }
@@ -113,6 +118,27 @@ bool ManagerBase::initFromCommandLine(int argc, char **argv) {
         currentOptDef = options->findOptionByName("ipf-maxit");
         setOptionFloat(currentOptDef, 266);
     }
+    if (!getOptionFloat("ipf-threads", NULL, &value)) {
+        currentOptDef = options->findOptionByName("ipf-threads");
+        setOptionFloat(currentOptDef, 1);
+    }
+    if (!getOptionFloat("projection-threads", NULL, &value)) {
+        currentOptDef = options->findOptionByName("projection-threads");
+        setOptionFloat(currentOptDef, 1);
+    }
+    if (!getOptionFloat("ipf-warm-start", NULL, &value)) {
+        currentOptDef = options->findOptionByName("ipf-warm-start");
+        setOptionFloat(currentOptDef, 0);
+    }
+    if (!getOptionFloat("table-budget", NULL, &value)) {
+        currentOptDef = options->findOptionByName("table-budget");
+        setOptionFloat(currentOptDef, 0);
+    }
+    //-- state spaces up to this size are fit with dense arrays rather than sparse tables
+    if (!getOptionFloat("dense-threshold", NULL, &value)) {
+        currentOptDef = options->findOptionByName("dense-threshold");
+        setOptionFloat(currentOptDef, 1000000);
+    }
 
     inputData = input;
     testData = test;
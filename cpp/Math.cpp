@@ -7,9 +7,11 @@
 
 #include <math.h>
 
+#include "Key.h"
 #include "Math.h"
 #include "Model.h"
 #include "Relation.h"
+#include "VectorMath.h"
 #include "_Core.h"
 
 #include <stdio.h>
@@ -17,36 +19,134 @@
 #include <float.h>
 #include "Constants.h"
 
+//-- values are gathered from tables in blocks of this many, for the vector kernels
+static const int VALUE_BLOCK = 256;
+
 double ocEntropy(Table *p) {
     double h = 0.0;
     long long count = p->getTupleCount();
-    double pv;
-    for (long long i = 0; i < count; ++i) {
-        pv = p->getValue(i);
-        if (pv > PROB_MIN)
-            h -= pv * log(pv);
+    double pv[VALUE_BLOCK];
+    //-- a columnar table's values are summed in place, in the same blocks, for the same result
+    const ocTupleValue *column = p->getValueColumn();
+    for (long long i = 0; i < count; i += VALUE_BLOCK) {
+        long long n = count - i < VALUE_BLOCK ? count - i : VALUE_BLOCK;
+        if (column == NULL)
+            p->copyValues(i, n, pv);
+        h -= ocSumPLogP(column ? column + i : pv, n);
     }
     h /= log(2.0); // convert h to log2 rather than ln
     return h;
 }
 
+//-- the loop of ocJoinValues, for keys of N segments (see Key::FixedKeys)
+template <int N, typename F>
+static void joinValues(Table *p, Table *q, bool outer, F accumulate) {
+    int keysize = p->getKeySize();
+    double pv[VALUE_BLOCK], qv[VALUE_BLOCK];
+    int n = 0;
+    long long pCount = p->getTupleCount();
+    long long qCount = q->getTupleCount();
+    long long i = 0, j = 0;
+    while (i < pCount || (outer && j < qCount)) {
+        int compare;
+        if (i >= pCount)
+            compare = 1;
+        else if (j >= qCount)
+            compare = -1;
+        else
+            compare = Key::FixedKeys<N>::compare(p->getKey(i), q->getKey(j), keysize);
+        if (compare == 0) {
+            pv[n] = p->getValue(i++);
+            qv[n] = q->getValue(j++);
+        } else if (compare < 0) {
+            pv[n] = p->getValue(i++);
+            qv[n] = 0.0;
+        } else {
+            j++;
+            if (!outer)
+                continue;
+            pv[n] = 0.0;
+            qv[n] = q->getValue(j - 1);
+        }
+        if (++n == VALUE_BLOCK) {
+            accumulate(pv, qv, n);
+            n = 0;
+        }
+    }
+    if (n > 0)
+        accumulate(pv, qv, n);
+}
+
+/**
+ * ocJoinValues - merge-join two tables sorted by key. The values of each pair of tuples
+ * with equal keys are gathered into blocks, with 0 standing in for a tuple q lacks (or,
+ * if outer, for one p lacks; otherwise tuples only q has are skipped). Each block is
+ * passed to accumulate(pv, qv, n), so its loop runs over plain arrays the compiler can
+ * vectorize, rather than interleaving with the key comparisons.
+ */
+template <typename F>
+static void ocJoinValues(Table *p, Table *q, bool outer, F accumulate) {
+    //-- a hashed table is in insertion order; sort it before walking it
+    if (p->isHashed()) p->finalize();
+    if (q->isHashed()) q->finalize();
+    KEY_SWITCH(p->getKeySize(), joinValues, (p, q, outer, accumulate));
+}
+
 double ocTransmission(Table *p, Table *q) {
     // To prevent underflow errors, probabilities
     // less than PROB_MIN are considered zero.
     double h = 0.0;
-    long long count = p->getTupleCount();
-    for (long long i = 0; i < count; i++) {
-        double pv = p->getValue(i);
-        KeySegment *pv_key = p->getKey(i);
-        long long qi_index = q->indexOf(pv_key); // find matching entry in q
-        double qi = qi_index >= 0 ? q->getValue(qi_index) : 0.0;
-        if (qi > PROB_MIN && pv > PROB_MIN)
-            h += pv * log(pv / qi);
-    }
+    ocJoinValues(p, q, false, [&](const double *pv, const double *qv, int n) {
+        h += ocSumPLogPQ(pv, qv, n);
+    });
     h /= log(2.0); // convert h to log2 rather than ln
     return h;
 }
 
+//-- Kullback-Leibler distance as batch compare reports it (see py/distanceFunctions.py).
+//-- Tuples missing from p contribute nothing, so this is the same sum as ocTransmission.
+double ocTransmissionFlat(Table *p, Table *q) {
+    return ocTransmission(p, q);
+}
+
+//-- The distances below are taken over every key in either table, as in
+//-- py/distanceFunctions.py.
+double ocAbsDist(Table *p, Table *q) {
+    double d = 0.0;
+    ocJoinValues(p, q, true, [&](const double *pv, const double *qv, int n) {
+        for (int k = 0; k < n; k++)
+            d += fabs(pv[k] - qv[k]);
+    });
+    return d;
+}
+
+double ocEucDist(Table *p, Table *q) {
+    double d = 0.0;
+    ocJoinValues(p, q, true, [&](const double *pv, const double *qv, int n) {
+        for (int k = 0; k < n; k++)
+            d += (pv[k] - qv[k]) * (pv[k] - qv[k]);
+    });
+    return sqrt(d);
+}
+
+double ocHellingerDist(Table *p, Table *q) {
+    double bc = 0.0; // Bhattacharyya coefficient
+    ocJoinValues(p, q, true, [&](const double *pv, const double *qv, int n) {
+        for (int k = 0; k < n; k++)
+            bc += sqrt(pv[k] * qv[k]);
+    });
+    return sqrt(1 - bc);
+}
+
+double ocMaxDist(Table *p, Table *q) {
+    double d = 0.0;
+    ocJoinValues(p, q, true, [&](const double *pv, const double *qv, int n) {
+        for (int k = 0; k < n; k++)
+            d = fmax(d, fabs(pv[k] - qv[k]));
+    });
+    return d;
+}
+
 // TODO: Rewrite this to use a "iteratorWithFlat" function;
 // currently it unnecessarily flattens the input before comparing to the margin,
 // where it would be nicer to just iterate over states in the input and margin.
@@ -73,17 +173,14 @@ double ocPearsonChiSquared(Table *p, Table *q, long sampleSize) {
     // To prevent underflow errors, probabilities
     // less than PROB_MIN are considered zero.
     double p2 = 0.0;
-    long count = p->getTupleCount();
-    for (long i = 0; i < count; i++) {
-        double pi = p->getValue(i);
-        KeySegment *pi_key = p->getKey(i);
-        long qi_index = q->indexOf(pi_key); // find matching entry in q
-        double qi = qi_index >= 0 ? q->getValue(qi_index) : 0.0;
-        if (pi < PROB_MIN)
-            p2 += qi; // works even if q1 near zero
-        else if (qi > PROB_MIN)
-            p2 += (pi - qi) * (pi - qi) / qi;
-    }
+    ocJoinValues(p, q, false, [&](const double *pv, const double *qv, int n) {
+        for (int k = 0; k < n; k++) {
+            if (pv[k] < PROB_MIN)
+                p2 += qv[k]; // works even if q1 near zero
+            else if (qv[k] > PROB_MIN)
+                p2 += (pv[k] - qv[k]) * (pv[k] - qv[k]) / qv[k];
+        }
+    });
     p2 *= sampleSize;
     return p2;
 }
@@ -39,7 +39,6 @@ Model::Model(int size) {
     attributeList = new AttributeList(6);
     printName = NULL;
     inverseName = NULL;
-    hashNext = NULL;
     progenitor = NULL;
     ID = 0;
     structMatrix = NULL;
@@ -184,7 +183,11 @@ void Model::makeStructMatrix(int statespace, VariableList *vars, int **stateSpac
         }
         structMatrix[constraintCount][i] = 1; //the default constraint
     }
-    constraintCount = 0;
+    //-- each state lies in at most one constraint cell per relation: mask the state's
+    //-- key down to the relation and look that cell up in the relation's constraints
+    int keysize = vars->getKeySize();
+    KeySegment *stateKey = new KeySegment[keysize];
+    KeySegment *cellKey = new KeySegment[keysize];
     int totalConstraintCount = 0;
     for (i = 0; i < relCount; i++) {
         Relation *rel = getRelation(i);
@@ -198,21 +201,21 @@ void Model::makeStructMatrix(int statespace, VariableList *vars, int **stateSpac
             printf("error happened in file : Model.cpp after getConstraintCount\n");
             exit(1);
         }
-        for (long j = 0; j < constraintCount; j++) {
-            KeySegment* key = sc->getConstraint(j);
-            if (key == NULL) {
-                printf("error happened in file : Model.cpp after getConstraint\n");
-                exit(1);
+        KeySegment *mask = rel->getMask();
+        for (int state = 0; state < statespace; state++) {
+            Key::buildFullKey(stateKey, keysize, vars, stateSpaceArr[state]);
+            for (int k = 0; k < keysize; k++) {
+                cellKey[k] = stateKey[k] | mask[k];
             }
-            int counter;
-            int *indices = getIndicesFromKey(key, vars, statespace, stateSpaceArr, &counter);
-            for (int k = 0; k < counter; k++) {
-                structMatrix[totalConstraintCount + j][indices[k]] = 1;
+            long j = sc->indexOf(cellKey);
+            if (j >= 0) {
+                structMatrix[totalConstraintCount + j][state] = 1;
             }
-            delete[] indices;
         }
         totalConstraintCount += constraintCount;
     }
+    delete[] stateKey;
+    delete[] cellKey;
 }
 
 void Model::completeSbModel() {
@@ -141,6 +141,34 @@ static void setStandardOptions(Options *opts) {
     opts->addOptionValue(def, "#", "");
     def = opts->addOptionName("ipf-maxdev", "i", "Max error in IPF, default=0.25");
     opts->addOptionValue(def, "#", "");
+    def = opts->addOptionName("ipf-threads", "", "Threads for IPF fitting, default=1 (0=all cores)");
+    opts->addOptionValue(def, "#", "");
+    def = opts->addOptionName("ipf-accelerate", "", "Extrapolate IPF passes to converge in fewer iterations; fits stop at a different point within ipf-maxdev, so statistics can differ slightly from plain IPF, default=0 (off)");
+    opts->addOptionValue(def, "#", "");
+    def = opts->addOptionName("ipf-trace", "", "Print the max deviation of each IPF pass, default=0 (off)");
+    opts->addOptionValue(def, "#", "");
+    def = opts->addOptionName("fit-method", "", "Method for fitting models with loops, default=ipf");
+    opts->addOptionValue(def, "ipf", "iterative proportional fitting over the whole state space");
+    opts->addOptionValue(def, "junction-tree", "triangulate the model, and use IPF only within its loops");
+    def = opts->addOptionName("ipf-warm-start", "", "Search levels of fits to keep for starting IPF from the progenitor's fit, default=0 (off)");
+    opts->addOptionValue(def, "#", "");
+    def = opts->addOptionName("ipf-warm-check", "", "Also fit warm-started models from the usual start, to report iterations saved, default=0 (off)");
+    opts->addOptionValue(def, "#", "");
+    def = opts->addOptionName("projection-threads", "", "Threads for projecting relation tables, default=1 (0=all cores)");
+    opts->addOptionValue(def, "#", "");
+    def = opts->addOptionName("parse-threads", "", "Threads for parsing the data, default=1 (0=all cores)");
+    opts->addOptionValue(def, "#", "");
+    def = opts->addOptionName("data-memory", "", "Memory for summing data as it is read, in MB, default=0 (no limit)");
+    opts->addOptionValue(def, "#", "");
+    def = opts->addOptionName("table-budget", "", "Memory for cached relation tables, in MB, default=0 (no limit)");
+    opts->addOptionValue(def, "#", "");
+    def = opts->addOptionName("projection-cache", "", "Directory for keeping relation tables between runs, default none");
+    opts->addOptionValue(def, "$", "");
+    def = opts->addOptionName("table-layout", "", "Storage for table tuples, default=interleaved");
+    opts->addOptionValue(def, "interleaved", "each key followed by its value");
+    opts->addOptionValue(def, "columnar", "keys and values in separate arrays");
+    def = opts->addOptionName("dense-threshold", "", "Max state space size for dense fit tables, default=1000000 (0=off)");
+    opts->addOptionValue(def, "#", "");
     def = opts->addOptionName("no-frequency", "", "There is no frequency data in table");
     def = opts->addOptionName("function-values", "", "Values represent function data, not frequencies.");
     opts->addOptionValue(def, "$", "");
@@ -264,7 +292,8 @@ void Options::setOptions(int argc, char **argv) {
     ocOptionDef *currentOptDef = findOptionByName("");
     for (int i = 1; i < argc; i++) {
         const char *cp = argv[i];
-        if (cp[0] == '-') {
+        //-- a lone "-" is a value (as a datafile, the standard input)
+        if (cp[0] == '-' && cp[1] != '\0') {
             if (cp[1] == '-') {
                 //-- long form: --name=value (or for booleans, just --name)
                 char * eqpos = strchr((char *) cp + 2, '=');
@@ -323,22 +352,51 @@ void Options::setOptions(int argc, char **argv) {
     return;
 }
 
-bool Options::getLine(FILE *fd, char *line, int *lineno) {
+//-- character sources for readLine. atEnd() becomes true once a read has been tried
+//-- past the end, as feof() does, or has failed.
+//-- getLine locks the file once for the line, so each character is read unlocked
+struct FileSource {
+    FILE *fd;
+    char next() {
+        return (char) getc_unlocked(fd);
+    }
+    bool atEnd() {
+        return feof_unlocked(fd) || ferror_unlocked(fd);
+    }
+};
+
+struct BufferSource {
+    const char *pos;
+    const char *end;
+    bool eof;
+    char next() {
+        if (pos < end)
+            return *pos++;
+        eof = true;
+        return (char) EOF;
+    }
+    bool atEnd() {
+        return eof;
+    }
+};
+
+template <typename Source>
+static bool readLine(Source &source, char *line, int *lineno) {
     int count;
     char current;
     line[0] = '\0';
     while (true) {
         count = 0;
         while (count < MAXLINE) {
-            current = (char) fgetc(fd);
-            if ((count == 0) && feof(fd))
+            current = source.next();
+            if ((count == 0) && source.atEnd())
                 break;
-            if ((current == '\r') || (current == '\n') || feof(fd)) {
+            if ((current == '\r') || (current == '\n') || source.atEnd()) {
                 line[count++] = '\n';
                 break;
             } else if (current == '#') {
-                while ((current != '\r') && (current != '\n') && !feof(fd)) {
-                    current = (char) fgetc(fd);
+                while ((current != '\r') && (current != '\n') && !source.atEnd()) {
+                    current = source.next();
                 }
                 if (count == 0)
                     continue;
@@ -369,6 +427,21 @@ bool Options::getLine(FILE *fd, char *line, int *lineno) {
     return false; // end of file
 }
 
+bool Options::getLine(FILE *fd, char *line, int *lineno) {
+    FileSource source = { fd };
+    flockfile(fd);
+    bool result = readLine(source, line, lineno);
+    funlockfile(fd);
+    return result;
+}
+
+bool Options::getLine(const char **pos, const char *end, char *line, int *lineno) {
+    BufferSource source = { *pos, end, false };
+    bool result = readLine(source, line, lineno);
+    *pos = source.pos;
+    return result;
+}
+
 bool Options::readOptions(FILE *fd) {
     //-- Read options from a file.  The option name is on a line by itself,
     //-- starting with a colon.  Any option values follow on separate lines
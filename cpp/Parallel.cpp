@@ -0,0 +1,84 @@
+/*
+ * Copyright © 1990 The Portland State University OCCAM Project Team
+ * [This program is licensed under the GPL version 3 or later.]
+ * Please see the file LICENSE in the source
+ * distribution of this software for license terms.
+ */
+
+#include "Parallel.h"
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+/**
+ * ThreadPool - the threads behind ocRunParallel. Worker t (from 1) runs task t of each
+ * job which has that many tasks. A job is published under the lock with a new generation
+ * number, and the caller waits until every task has finished, so only one job is ever
+ * running; busy is held for the whole job, so a second caller can tell. The pool is never
+ * deleted, and its threads are detached, so they are simply stopped when the program ends.
+ */
+class ThreadPool {
+    public:
+        ThreadPool() : job(NULL), jobTasks(0), generation(0), remaining(0) {}
+
+        //-- run a job on the pool; false, having run nothing, if the pool is busy
+        bool run(int tasks, const std::function<void(int)> &task) {
+            if (!busy.try_lock())
+                return false;
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                while ((int) workers.size() < tasks - 1) {
+                    workers.push_back(std::thread(&ThreadPool::work, this, (int) workers.size() + 1));
+                    workers.back().detach();
+                }
+                job = &task;
+                jobTasks = tasks;
+                remaining = tasks - 1;
+                generation++;
+            }
+            start.notify_all();
+            task(0);
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                done.wait(guard, [this]() { return remaining == 0; });
+                job = NULL;
+            }
+            busy.unlock();
+            return true;
+        }
+
+    private:
+        void work(int t) {
+            long long seen = 0;
+            std::unique_lock<std::mutex> guard(lock);
+            while (true) {
+                start.wait(guard, [this, &seen]() { return generation != seen; });
+                seen = generation;
+                if (t >= jobTasks)
+                    continue;
+                const std::function<void(int)> *task = job;
+                guard.unlock();
+                (*task)(t);
+                guard.lock();
+                if (--remaining == 0)
+                    done.notify_one();
+            }
+        }
+
+        std::mutex busy; // held while a job runs
+        std::mutex lock; // guards the fields below
+        std::condition_variable start, done;
+        std::vector<std::thread> workers;
+        const std::function<void(int)> *job;
+        int jobTasks;
+        long long generation;
+        int remaining; // tasks of the job, other than task 0, still running
+};
+
+void ocRunParallel(int tasks, const std::function<void(int)> &task) {
+    static ThreadPool *pool = new ThreadPool();
+    if (tasks > 1 && pool->run(tasks, task))
+        return;
+    for (int t = 0; t < tasks; t++)
+        task(t);
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright © 1990 The Portland State University OCCAM Project Team
+ * [This program is licensed under the GPL version 3 or later.]
+ * Please see the file LICENSE in the source
+ * distribution of this software for license terms.
+ */
+
+#include "ProjectionCache.h"
+#include "Key.h"
+#include "Relation.h"
+#include "Table.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char CACHE_MAGIC[8] = { 'O', 'C', 'C', 'P', 'R', 'O', 'J', '1' };
+
+//-- the fixed part of a cache file; the mask (keysize segments) and the tuples follow it
+struct CacheHeader {
+    char magic[8];
+    long long keysize;
+    unsigned long long fingerprint;
+    long long tupleCount;
+};
+
+
+ProjectionCache::ProjectionCache(const char *cacheDir, Table *data) {
+    dir = new char[strlen(cacheDir) + 1];
+    strcpy(dir, cacheDir);
+    keysize = data->getKeySize();
+    hits = 0;
+    warned = false;
+
+    unsigned long long h = 0xcbf29ce484222325ULL ^ (unsigned long long) keysize;
+    long long count = data->getTupleCount();
+    for (long long i = 0; i < count; i++) {
+        double value = data->getValue(i);
+        unsigned long long bits;
+        memcpy(&bits, &value, sizeof(bits));
+        h = (h ^ Key::hashKey(data->getKey(i), keysize)) * 0x100000001b3ULL;
+        h = (h ^ bits) * 0x100000001b3ULL;
+    }
+    fingerprint = h ^ (unsigned long long) count;
+}
+
+
+ProjectionCache::~ProjectionCache() {
+    delete[] dir;
+}
+
+
+void ProjectionCache::makePath(Relation *rel, char *path, int size) {
+    snprintf(path, size, "%s/%016llx-%016llx.proj", dir, fingerprint, Key::hashKey(rel->getMask(), keysize));
+}
+
+
+Table *ProjectionCache::load(Relation *rel) {
+    char path[strlen(dir) + 64];
+    makePath(rel, path, sizeof(path));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+    struct stat st;
+    size_t maskBytes = keysize * sizeof(KeySegment);
+    size_t tupleBytes = maskBytes + sizeof(ocTupleValue);
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(CacheHeader) + maskBytes) {
+        close(fd);
+        return NULL;
+    }
+    size_t length = st.st_size;
+    void *base = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+        return NULL;
+
+    //-- check that the file really is this relation's table, and complete
+    CacheHeader *header = (CacheHeader*) base;
+    KeySegment *mask = (KeySegment*) (header + 1);
+    if (memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header->keysize != keysize
+            || header->fingerprint != fingerprint || header->tupleCount < 0
+            || memcmp(mask, rel->getMask(), maskBytes) != 0
+            || length != sizeof(CacheHeader) + maskBytes + header->tupleCount * tupleBytes) {
+        munmap(base, length);
+        return NULL;
+    }
+    Table *table = new Table(keysize, 1);
+    table->attachMapped(base, length, (char*) base + sizeof(CacheHeader) + maskBytes, header->tupleCount);
+    hits++;
+    return table;
+}
+
+
+void ProjectionCache::save(Relation *rel, Table *table) {
+    char path[strlen(dir) + 64];
+    makePath(rel, path, sizeof(path));
+    //-- write under a temporary name and rename, so a reader never sees a partial file
+    char temp[sizeof(path) + 32];
+    snprintf(temp, sizeof(temp), "%s.%ld.tmp", path, (long) getpid());
+    FILE *fp = fopen(temp, "wb");
+    bool ok = fp != NULL;
+    if (ok) {
+        CacheHeader header;
+        memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        header.keysize = keysize;
+        header.fingerprint = fingerprint;
+        header.tupleCount = table->getTupleCount();
+        ok = fwrite(&header, sizeof(header), 1, fp) == 1
+                && fwrite(rel->getMask(), sizeof(KeySegment), keysize, fp) == (size_t) keysize;
+        for (long long i = 0; ok && i < header.tupleCount; i++) {
+            ocTupleValue value = table->getValue(i);
+            ok = fwrite(table->getKey(i), sizeof(KeySegment), keysize, fp) == (size_t) keysize
+                    && fwrite(&value, sizeof(value), 1, fp) == 1;
+        }
+        ok = (fclose(fp) == 0) && ok;
+    }
+    if (ok)
+        ok = rename(temp, path) == 0;
+    if (!ok) {
+        unlink(temp);
+        if (!warned)
+            printf("WARNING: could not write projection cache file %s\n", path);
+        warned = true;
+    }
+}
@@ -7,100 +7,158 @@
 
 #include "Relation.h"
 #include "RelCache.h"
+#include "Table.h"
 
+#include <algorithm>
+#include <vector>
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <memory.h>
 #include <string.h>
 
-static int hashcode(const char *name, int hashsize) {
-    unsigned int key = 0;
-    for (const char *cp = name; *cp; cp++)
-        key = (key << 1) + *cp;
-    return key % hashsize;
-}
-
 RelCache::RelCache() {
-    hash = new Relation*[RELCACHE_HASHSIZE];
-    memset(hash, 0, RELCACHE_HASHSIZE * sizeof(Relation*));
+    useClock = 0;
 }
 
 //-- destroy relation cache.  This also deletes all the relations held in the cache.
 RelCache::~RelCache() {
-    Relation *r1, *r2;
-    int i;
-    for (i = 0; i < RELCACHE_HASHSIZE; i++) {
-        r1 = hash[i];
-        while (r1) {
-            r2 = r1->getHashNext();
-            delete r1;
-            r1 = r2;
-        }
-    }
-    delete hash;
+    relations.forEach([](Relation *rel) {
+        delete rel;
+    });
 }
 
 long RelCache::size() {
-    long size = RELCACHE_HASHSIZE * sizeof(Relation*);
-    Relation *r1;
-    int i;
-    for (i = 0; i < RELCACHE_HASHSIZE; i++) {
-        r1 = hash[i];
-        while (r1) {
-            size += r1->size();
-            r1 = r1->getHashNext();
-        }
-    }
+    long size = relations.size();
+    relations.forEach([&](Relation *rel) {
+        size += rel->size();
+    });
     return size;
 }
 
 //-- delete tables from all relations
 void RelCache::deleteTables() {
-    Relation *r1;
-    int i;
-    for (i = 0; i < RELCACHE_HASHSIZE; i++) {
-        r1 = hash[i];
-        while (r1) {
-            r1->deleteTable();
-            r1 = r1->getHashNext();
-        }
-    }
+    relations.forEach([](Relation *rel) {
+        rel->deleteTable();
+    });
+    std::lock_guard<std::mutex> guard(tableLock);
+    tables.clear();
 }
 
 //-- addRelation - put a new relation in the cache. If a matching relation already
 //-- exists, an error is returned.
-// [JSF] This doesn't seem to check for matches, or return errors.
 bool RelCache::addRelation(class Relation *rel) {
-    if (findRelation(rel->getPrintName()) != NULL)
-        return false; //error; exists
-    KeySegment *mask = rel->getMask();
-    int hashindex = hashcode(rel->getPrintName(), RELCACHE_HASHSIZE);
-    rel->setHashNext(hash[hashindex]);
-    hash[hashindex] = rel;
-    return true;
+    return relations.findOrAdd(rel) == rel;
+}
+
+class Relation *RelCache::findOrAddRelation(class Relation *rel) {
+    return relations.findOrAdd(rel);
 }
 
 //-- findRelation - find a relation in the cache.  Null is returned if the given
 //-- relation doesn't exist.
 class Relation *RelCache::findRelation(const char *name) {
-    int hashindex = hashcode(name, RELCACHE_HASHSIZE);
-    Relation *rp = hash[hashindex];
-    while (rp && strcmp(name, rp->getPrintName()) != 0)
-        rp = rp->getHashNext();
-    return rp; // either NULL, or the matching one
+    return relations.find(name);
 }
 
-//-- dump - print out all relations in the cache
-void RelCache::dump() {
-    printf("\nDumping RelCache:\n");
-    for (int i = 0; i < RELCACHE_HASHSIZE; i++) {
-        if (hash[i]) {
-            printf("hash chain [%d]:\n", i);
-            for (Relation *rel = hash[i]; rel; rel = rel->getHashNext()) {
-                rel->dump();
+bool RelCache::TableOrder::operator()(const std::pair<long long, Relation*> &a,
+        const std::pair<long long, Relation*> &b) const {
+    if (a.first != b.first)
+        return a.first < b.first;
+    return strcmp(a.second->getPrintName(), b.second->getPrintName()) < 0;
+}
+
+//-- addTable - index the relation under its variable count, by its table's size
+void RelCache::addTable(class Relation *rel) {
+    Table *table = rel->getTable();
+    if (table == NULL || rel->isStateBased())
+        return;
+    std::lock_guard<std::mutex> guard(tableLock);
+    int varCount = rel->getVariableCount();
+    if ((int) tables.size() <= varCount)
+        tables.resize(varCount + 1);
+    tables[varCount].insert(std::make_pair(table->getTupleCount(), rel));
+}
+
+//-- findSmallestSuperset - the indexed relation with the smallest table which contains rel
+//-- (ties go to the first by name, so the choice doesn't depend on the cache's layout).
+//-- Only relations with more variables can contain rel, and each of those sets is in
+//-- order of size, so the scan of a set stops at the first match or at the best so far.
+class Relation *RelCache::findSmallestSuperset(class Relation *rel) {
+    std::lock_guard<std::mutex> guard(tableLock);
+    Relation *best = NULL;
+    long long bestCount = 0;
+    for (size_t v = rel->getVariableCount() + 1; v < tables.size(); v++) {
+        TableSet &set = tables[v];
+        for (TableSet::iterator it = set.begin(); it != set.end();) {
+            Relation *rp = it->second;
+            Table *table = rp->getTable();
+            //-- the table was deleted, or replaced (and the new one indexed) since
+            if (table == NULL || table->getTupleCount() != it->first) {
+                it = set.erase(it);
+                continue;
+            }
+            if (best && (it->first > bestCount || (it->first == bestCount
+                    && strcmp(rp->getPrintName(), best->getPrintName()) > 0)))
+                break;
+            if (rp->contains(rel)) {
+                best = rp;
+                bestCount = it->first;
+                break;
             }
+            ++it;
         }
     }
+    return best;
+}
+
+unsigned long long RelCache::touch(class Relation *rel) {
+    std::lock_guard<std::mutex> guard(lock);
+    rel->setUseStamp(++useClock);
+    return useClock;
+}
+
+unsigned long long RelCache::getUseClock() {
+    std::lock_guard<std::mutex> guard(lock);
+    return useClock;
+}
+
+//-- trimTables - tally the tables, then release the oldest candidates until within budget
+long RelCache::trimTables(long long budget, unsigned long long since, class Table *keep) {
+    std::lock_guard<std::mutex> guard(lock);
+    std::vector<Relation*> candidates;
+    long long total = 0;
+    relations.forEach([&](Relation *rp) {
+        Table *table = rp->getTable();
+        if (table == NULL || table == keep)
+            return;
+        total += table->size();
+        if (rp->getUseStamp() <= since)
+            candidates.push_back(rp);
+    });
+    if (total <= budget)
+        return 0;
+    std::sort(candidates.begin(), candidates.end(), [](Relation *a, Relation *b) {
+        return a->getUseStamp() < b->getUseStamp();
+    });
+    long released = 0;
+    for (size_t i = 0; i < candidates.size() && total > budget; i++) {
+        total -= candidates[i]->getTable()->size();
+        candidates[i]->deleteTable();
+        released++;
+    }
+    return released;
+}
+
+void RelCache::reclaim() {
+    relations.reclaim();
+}
+
+//-- dump - print out all relations in the cache
+void RelCache::dump() {
+    printf("\nDumping RelCache:\n");
+    relations.forEach([](Relation *rel) {
+        rel->dump();
+    });
 }
 
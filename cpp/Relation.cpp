@@ -30,7 +30,7 @@ Relation::Relation(VariableList *list, int size, int keysz, long stateconstsz) {
         stateConstraints = new StateConstraint(keysz, stateconstsz);
     }
     mask = NULL;
-    hashNext = NULL;
+    useStamp = 0;
     attributeList = new AttributeList(2);
     printName = NULL;
     inverseName = NULL;
@@ -435,9 +435,7 @@ double Relation::getMatchingTupleValue(KeySegment *key) {
 
     //-- fill the key with the input key, masking off variables we don't care about.
 
-    for (int i = 0; i < keysize; i++) {
-        newKey[i] = key[i] | mask[i];
-    }
+    Key::applyMask(newKey, key, mask, keysize);
 //    printf(" GIVING NEW KEY: ");
 //    Key::dumpKey(newKey, keysize);
 //    printf(" LOOKING IN TABLE: ");
@@ -10,6 +10,7 @@
 #include "_Core.h"
 #include "Report.h"
 #include "ManagerBase.h"
+#include "AttributeList.h"
 #include "Math.h"
 #include <string.h>
 #include <ctype.h>
@@ -148,6 +149,14 @@ void Report::print(FILE *fd) {
                     (double) idOrder[(int) models[m]->getAttribute(ATTRIBUTE_PROG_ID)]);
         }
     }
+    // Likewise the models that IPF was warm-started from (-1 for none), where recorded.
+    for (int m = 0; m < modelCount; m++) {
+        if (models[m]->getAttributeList()->getAttributeIndex(ATTRIBUTE_IPF_WARM_START) < 0)
+            continue;
+        int warmID = (int) models[m]->getAttribute(ATTRIBUTE_IPF_WARM_START);
+        if (warmID >= 0 && warmID <= modelCount)
+            models[m]->setAttribute(ATTRIBUTE_IPF_WARM_START, (double) idOrder[warmID]);
+    }
 
     // Print out the search results for each model, with the header before and after
     if (htmlMode)
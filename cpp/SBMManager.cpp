@@ -177,8 +177,8 @@ void SBMManager::makeReferenceModels(Relation *top) {
         model->completeSbModel();
     }
     bottomRef = model;
-    if (!modelCache->addModel(bottomRef)) {
-        Model *cached_model = modelCache->findModel(bottomRef->getPrintName());
+    Model *cached_model = modelCache->findOrAddModel(bottomRef);
+    if (cached_model != bottomRef) {
         delete bottomRef;
         bottomRef = cached_model;
     }
@@ -289,9 +289,9 @@ void SearchFullUp::makeCandidate(SearchStackEntry *stack, int top, Model *start)
     newModel->copyRelations(*start);
     newModel->addRelation(rel, true);
     ModelCache *cache = manager->getModelCache();
-    if (!cache->addModel(newModel)) {
+    Model *cachedModel = cache->findOrAddModel(newModel);
+    if (cachedModel != newModel) {
         //-- already exists in cache; return that one
-        Model *cachedModel = cache->findModel(newModel->getPrintName());
         delete newModel;
         newModel = cachedModel;
         //-- since all models come from the cache, we can do pointer compares to see if
@@ -411,8 +411,8 @@ void SearchSbFullUp::recurseDirected(Model *start, int cur_var, int cur_index, i
 bool SearchSbFullUp::addToCache(Model *model, int &models_found, Model **model_list) {
     ModelCache* cache = manager->getModelCache();
     // put the model in the cache, or use the cached one if already there
-    if (!cache->addModel(model)) {
-        Model *cached_model = cache->findModel(model->getPrintName());
+    Model *cached_model = cache->findOrAddModel(model);
+    if (cached_model != model) {
         delete model;
         model = cached_model;
     }
@@ -574,8 +574,8 @@ Model **SearchLooplessDown::search(Model *start) {
             model->addRelation(newRel);
             // put in cache, or use the cached one if already there
             ModelCache *cache = manager->getModelCache();
-            if (!cache->addModel(model)) {
-                Model *cachedModel = cache->findModel(model->getPrintName());
+            Model *cachedModel = cache->findOrAddModel(model);
+            if (cachedModel != model) {
                 delete model;
                 model = cachedModel;
             }
@@ -623,8 +623,8 @@ Model **SearchLooplessDown::search(Model *start) {
 
                     //-- put in cache, or use the cached one if already there
                     ModelCache *cache = manager->getModelCache();
-                    if (!cache->addModel(model)) {
-                        Model *cachedModel = cache->findModel(model->getPrintName());
+                    Model *cachedModel = cache->findOrAddModel(model);
+                    if (cachedModel != model) {
                         delete model;
                         model = cachedModel;
                     }
@@ -669,8 +669,8 @@ bool SearchSbLooplessUp::addToCache(Model *model, int &models_found, Model **mod
     ModelCache* cache = manager->getModelCache();
     Model* cached_model = NULL;
     // put the model in the cache, or use the cached one if already there
-    if (!cache->addModel(model)) {
-        Model *cached_model = cache->findModel(model->getPrintName());
+    cached_model = cache->findOrAddModel(model);
+    if (cached_model != model) {
         delete model;
         model = cached_model;
     }
@@ -913,8 +913,8 @@ Model **SearchLooplessUp::search(Model *start) {
                                 model->addRelation(newRel, true);
                                 // put the model in the cache, or use the cached one if already there
                                 ModelCache *cache = manager->getModelCache();
-                                if (!cache->addModel(model)) {
-                                    cachedModel = cache->findModel(model->getPrintName());
+                                cachedModel = cache->findOrAddModel(model);
+                                if (cachedModel != model) {
                                     delete model;
                                     model = cachedModel;
                                 }
@@ -984,8 +984,8 @@ Model **SearchLooplessUp::search(Model *start) {
                 model->addRelation(newRelation);
                 //-- put in cache, or use the cached one if already there
                 ModelCache *cache = manager->getModelCache();
-                if (!cache->addModel(model)) {
-                    Model *cachedModel = cache->findModel(model->getPrintName());
+                Model *cachedModel = cache->findOrAddModel(model);
+                if (cachedModel != model) {
                     delete model;
                     model = cachedModel;
                 }
@@ -1079,8 +1079,8 @@ Model **SearchDisjointUp::search(Model *start) {
                 model->addRelation(newRelation);
                 //-- put in cache, or use the cached one if already there
                 ModelCache *cache = manager->getModelCache();
-                if (!cache->addModel(model)) {
-                    Model *cachedModel = cache->findModel(model->getPrintName());
+                Model *cachedModel = cache->findOrAddModel(model);
+                if (cachedModel != model) {
                     delete model;
                     model = cachedModel;
                 }
@@ -1115,8 +1115,8 @@ Model **SearchDisjointUp::search(Model *start) {
             model->addRelation(newRelation);
             //-- put in cache, or use the cached one if already there
             ModelCache *cache = manager->getModelCache();
-            if (!cache->addModel(model)) {
-                Model *cachedModel = cache->findModel(model->getPrintName());
+            Model *cachedModel = cache->findOrAddModel(model);
+            if (cachedModel != model) {
                 delete model;
                 model = cachedModel;
             }
@@ -1198,8 +1198,8 @@ bool SearchChain::makeChainModels() {
         if (oldBrk == 0)
             oldBrk = (char*) sbrk(0);
         double used = ((char*) sbrk(0)) - oldBrk;
-        if (!cache->addModel(model)) {
-            Model *cachedModel = cache->findModel(model->getPrintName());
+        Model *cachedModel = cache->findOrAddModel(model);
+        if (cachedModel != model) {
             delete model;
             model = cachedModel;
         }
@@ -1326,8 +1326,8 @@ Model **SearchDisjointDown::search(Model *start) {
          model->addRelation(newRel);
          // put in cache, or use the cached one if already there
          ModelCache *cache = manager->getModelCache();
-         if (!cache->addModel(model)) {
-         Model *cachedModel = cache->findModel(model->getPrintName());
+         Model *cachedModel = cache->findOrAddModel(model);
+         if (cachedModel != model) {
          delete model;
          model = cachedModel;
          }
@@ -1366,8 +1366,8 @@ Model **SearchDisjointDown::search(Model *start) {
 
                     // add the model if it is not in the cache
                     ModelCache *cache = manager->getModelCache();
-                    if (!cache->addModel(m)) {
-                        Model *cachedModel = cache->findModel(m->getPrintName());
+                    Model *cachedModel = cache->findOrAddModel(m);
+                    if (cachedModel != m) {
                         delete m;
                         m = cachedModel;
                     }
@@ -1409,9 +1409,8 @@ Model **SearchDisjointDown::search(Model *start) {
                             //cout << "nh:2"<< endl;
                             // add the model if it is not in the cache
                             ModelCache *cache = manager->getModelCache();
-                            if (!cache->addModel(m1)) {
-
-                                Model *cachedModel = cache->findModel(m1->getPrintName());
+                            Model *cachedModel = cache->findOrAddModel(m1);
+                            if (cachedModel != m1) {
                                 delete m1;
                                 m1 = cachedModel;
                             }
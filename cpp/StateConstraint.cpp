@@ -6,6 +6,7 @@
  */
 
 #include "StateConstraint.h"
+#include "Key.h"
 #include "_Core.h"
 #include <assert.h>
 #include <stdio.h>
@@ -29,6 +30,8 @@ StateConstraint::StateConstraint(int keysz, long size)
     if (maxConstraintCount == 0) maxConstraintCount = 1;
     constraintCount = 0;
     constraints = new KeySegment[keysize * maxConstraintCount];
+    index = NULL;
+    indexRebuild(16);
 }
 
 
@@ -36,6 +39,7 @@ StateConstraint::~StateConstraint()
 {
     // delete storage
     delete[] constraints;
+    delete[] index;
 }
 
 
@@ -50,6 +54,13 @@ void StateConstraint::addConstraint(KeySegment *key)
     KeySegment *addr = keyAddr(constraintCount);	// get the address of the next key
     memcpy(addr, key, keysize*sizeof(KeySegment)); // and copy the new one
     constraintCount++;
+    if (2 * constraintCount >= indexCapacity) {
+        indexRebuild(indexCapacity * 2);  // indexes every constraint, including this one
+    } else {
+        long slot = Key::hashKey(addr, keysize) & (indexCapacity - 1);
+        while (index[slot] >= 0) slot = (slot + 1) & (indexCapacity - 1);
+        index[slot] = constraintCount - 1;
+    }
 }
 
 
@@ -74,3 +85,33 @@ int StateConstraint::getKeySize()
 }
 
 
+
+
+/**
+ * The constraint index works like a hashed Table: linear probing, kept at most half full.
+ * Constraints are never removed, so no tombstones are needed.
+ */
+void StateConstraint::indexRebuild(long capacity)
+{
+    delete[] index;
+    index = new long[capacity];
+    indexCapacity = capacity;
+    for (long i = 0; i < capacity; i++) index[i] = -1;
+    for (long i = 0; i < constraintCount; i++) {
+        long slot = Key::hashKey(keyAddr(i), keysize) & (indexCapacity - 1);
+        while (index[slot] >= 0) slot = (slot + 1) & (indexCapacity - 1);
+        index[slot] = i;
+    }
+}
+
+
+long StateConstraint::indexOf(KeySegment *key)
+{
+    long slot = Key::hashKey(key, keysize) & (indexCapacity - 1);
+    while (true) {
+        long i = index[slot];
+        if (i < 0) return -1;
+        if (Key::compareKeys(keyAddr(i), key, keysize) == 0) return i;
+        slot = (slot + 1) & (indexCapacity - 1);
+    }
+}
@@ -13,8 +13,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <vector>
 
 const long long GROWTH_FACTOR = 2;
+//-- the most scratch space groupBy keeps, per buffer and thread
+const long long GROUP_SCRATCH_LIMIT = 64LL << 20;
 
 
 /*
@@ -24,7 +28,10 @@ const long long GROWTH_FACTOR = 2;
  *
  * The data storage consists of {[keyseg 0]..[keyseg n][value]}..., in a contiguous
  * array. The macros below provide indexed access to this storage. Note that in order
- * for quicksort to work, the key must be first
+ * for quicksort to work, the key must be first. A columnar table instead keeps the keys
+ * alone in data and the values in a separate array; keyAt and valueAt work for both.
+ * Sorting always works on interleaved tuples, so a columnar table packs its tuples into
+ * that form to sort them, and unpacks the result.
  */
 
 #define TupleBytes (sizeof(ocTupleValue) + keysize * sizeof(KeySegment))
@@ -42,37 +49,94 @@ static KeySegment *KeyPtr(void *data, int keysize, long long index)
 }
 
 
+inline KeySegment *Table::keyAt(long long index) const
+{
+    if (layout == TableLayout::Columnar) return ((KeySegment*) data) + keysize * index;
+    return KeyPtr(data, keysize, index);
+}
+
+
+inline ocTupleValue *Table::valueAt(long long index) const
+{
+    if (layout == TableLayout::Columnar) return values + index;
+    return ValuePtr(data, keysize, index);
+}
+
+
+TableLayout Table::defaultLayout = TableLayout::Interleaved;
+
+
+void Table::setDefaultLayout(TableLayout layout)
+{
+    defaultLayout = layout;
+}
+
+
+TableLayout Table::getDefaultLayout()
+{
+    return defaultLayout;
+}
+
+
 Table::Table(int keysz, long long maxTuples, TableType typ)
 {
     keysize = keysz;
     type = typ;
     maxTupleCount = maxTuples;
     tupleCount = 0;
-    data = new char[TupleBytes * maxTuples];
-    memset(data, 0, TupleBytes * maxTuples * sizeof(char));
+    hashIndex = NULL;
+    hashCapacity = 0;
+    mapBase = NULL;
+    mapLength = 0;
+    normalTuples = NULL;
+    normalSum = 0;
+    layout = defaultLayout;
+    if (layout == TableLayout::Columnar) {
+        data = new char[keysize * sizeof(KeySegment) * maxTuples];
+        memset(data, 0, keysize * sizeof(KeySegment) * maxTuples);
+        values = (ocTupleValue*) new char[sizeof(ocTupleValue) * maxTuples];
+        memset(values, 0, sizeof(ocTupleValue) * maxTuples);
+    } else {
+        data = new char[TupleBytes * maxTuples];
+        memset(data, 0, TupleBytes * maxTuples * sizeof(char));
+        values = NULL;
+    }
 }
 
 
 Table::~Table()
 {
-    if (data) delete [] (char*)data;
+    if (mapBase) munmap(mapBase, mapLength);
+    else if (data) delete [] (char*)data;
+    if (values) delete [] (char*)values;
+    hashDrop();
 }
 
 
 long long Table::size()
 {
-    return TupleBytes * maxTupleCount + sizeof(Table);
+    return TupleBytes * maxTupleCount + hashCapacity * sizeof(long long) + sizeof(Table);
 }
 
 
 void Table::copy(const Table* from)
 {
-    while (from->tupleCount > maxTupleCount) {
-        data = growStorage(data, maxTupleCount*TupleBytes, GROWTH_FACTOR);
-        maxTupleCount *= GROWTH_FACTOR;
+    ownStorage();
+    reserve(from->tupleCount);
+    if (layout != from->layout) {
+        for (long long i = 0; i < from->tupleCount; i++) {
+            memcpy(keyAt(i), from->keyAt(i), keysize * sizeof(KeySegment));
+            *valueAt(i) = *from->valueAt(i);
+        }
+    } else if (layout == TableLayout::Columnar) {
+        memcpy(data, from->data, keysize * sizeof(KeySegment) * from->tupleCount);
+        memcpy(values, from->values, sizeof(ocTupleValue) * from->tupleCount);
+    } else {
+        memcpy(data, from->data, TupleBytes * from->tupleCount);
     }
-    memcpy(data, from->data, TupleBytes * maxTupleCount);
     tupleCount = from->tupleCount;
+    hashDrop();
+    if (from->hashIndex) beginHashed();
 }
 
 
@@ -82,16 +146,15 @@ void Table::copy(const Table* from)
  */
 void Table::addTuple(KeySegment *key, double value)
 {
-    while (tupleCount >= maxTupleCount) {
-        data = growStorage(data, maxTupleCount*TupleBytes, GROWTH_FACTOR);
-        maxTupleCount *= GROWTH_FACTOR;
-    }
-    KeySegment *keyptr = KeyPtr(data, keysize, tupleCount);
+    ownStorage();
+    reserve(tupleCount + 1);
+    KeySegment *keyptr = keyAt(tupleCount);
     memcpy(keyptr, key, sizeof(KeySegment) * keysize);			// copy key
     //-- for set relations, only values are 1 or 0
     if (type == TableType::SetTheoretic && value != 0.0) value = 1.0;
-    *(ValuePtr(data, keysize, tupleCount)) = (ocTupleValue) value;		// copy value
+    *(valueAt(tupleCount)) = (ocTupleValue) value;		// copy value
     tupleCount++;
+    if (hashIndex) hashInsert(tupleCount - 1);
 }
 
 
@@ -100,11 +163,14 @@ void Table::addTuple(KeySegment *key, double value)
  */
 void Table::insertTuple(KeySegment *key, double value, long long index)
 {
-    while (tupleCount >= maxTupleCount) {
-        data = growStorage(data, maxTupleCount*TupleBytes, GROWTH_FACTOR);
-        maxTupleCount *= GROWTH_FACTOR;
-    }
-    if (index < tupleCount) {
+    //-- positions are about to shift, so a hash index would go stale
+    hashDrop();
+    ownStorage();
+    reserve(tupleCount + 1);
+    if (index < tupleCount && layout == TableLayout::Columnar) {
+        memmove(keyAt(index + 1), keyAt(index), (tupleCount - index) * keysize * sizeof(KeySegment));
+        memmove(valueAt(index + 1), valueAt(index), (tupleCount - index) * sizeof(ocTupleValue));
+    } else if (index < tupleCount) {
         void* dest = KeyPtr(data, keysize, index + 1);
         void* src = KeyPtr(data, keysize, index);
         long size = ((char*)KeyPtr(data, keysize, tupleCount)) - ((char*)KeyPtr(data, keysize, index));
@@ -112,11 +178,11 @@ void Table::insertTuple(KeySegment *key, double value, long long index)
     }
     // else?
 
-    KeySegment *keyptr = KeyPtr(data, keysize, index);
+    KeySegment *keyptr = keyAt(index);
     memcpy(keyptr, key, sizeof(KeySegment) * keysize);	// copy key
     //-- for set relations, only values are 1 or 0
     if (type == TableType::SetTheoretic && value != 0.0) value = 1.0;
-    *(ValuePtr(data, keysize, index)) = (ocTupleValue) value;						// copy value
+    *(valueAt(index)) = (ocTupleValue) value;						// copy value
     tupleCount++;
 }
 
@@ -127,12 +193,25 @@ void Table::insertTuple(KeySegment *key, double value, long long index)
  */
 void Table::sumTuple(KeySegment *key, double value)
 {
+    ownStorage();
+    if (hashIndex) {
+        long long index = hashFind(key);
+        if (index < 0) {
+            addTuple(key, value);
+        } else {
+            ocTupleValue *valuep = valueAt(index);
+            value += *valuep;
+            if (type == TableType::SetTheoretic && value != 0.0) value = 1.0;
+            *valuep = (ocTupleValue) value;
+        }
+        return;
+    }
     long long index = indexOf(key, false);
     //-- index is either the matching tuple, or the next higher one. So we have to test again.
-    if (index >= tupleCount || Key::compareKeys(KeyPtr(data, keysize, index), key, keysize) != 0) {
+    if (index >= tupleCount || !Key::FixedKeys<0>::equal(keyAt(index), key, keysize)) {
         insertTuple(key, value, index);
     } else {
-        ocTupleValue *valuep = ValuePtr(data, keysize, index);
+        ocTupleValue *valuep = valueAt(index);
         value += *valuep;
         if (type == TableType::SetTheoretic && value != 0.0) value = 1.0;
         *valuep = (ocTupleValue) value;
@@ -148,7 +227,24 @@ void Table::sumTuple(KeySegment *key, double value)
 double Table::getValue(long long index)
 {
     if (index < 0 || index >= tupleCount) return 0.0;
-    return (double) *(ValuePtr(data, keysize, index));
+    return (double) *(valueAt(index));
+}
+
+
+/**
+ * copyValues - copy the values of count tuples, from index start on, into dest. Unless
+ * the layout is columnar, the values are interleaved with the keys, so this gathers them
+ * into a plain array for loops which only need the values.
+ */
+void Table::copyValues(long long start, long long count, double *dest)
+{
+    if (layout == TableLayout::Columnar) {
+        memcpy(dest, values + start, count * sizeof(ocTupleValue));
+        return;
+    }
+    for (long long i = 0; i < count; i++) {
+        dest[i] = *ValuePtr(data, keysize, start + i);
+    }
 }
 
 
@@ -158,7 +254,8 @@ double Table::getValue(long long index)
 void Table::setValue(long long index, double value)
 {
     if ((index < 0) || (index >= tupleCount)) return;
-    else *(ValuePtr(data, keysize, index)) = (ocTupleValue) value;
+    ownStorage();
+    *(valueAt(index)) = (ocTupleValue) value;
 }
 
 
@@ -168,7 +265,7 @@ void Table::setValue(long long index, double value)
 KeySegment *Table::getKey(long long index)
 {
     if (index < 0 || index >= tupleCount) return 0;
-    else return KeyPtr(data, keysize, index);
+    else return keyAt(index);
 }
 
 
@@ -184,9 +281,22 @@ void Table::copyKey(long long index, KeySegment *key)
 
 /**
  * indexOf - search the table for the given key, and return the index. Returns -1 if not
- * found. This function assumes the keys are sorted, and does a binary search.
+ * found. This function assumes the keys are sorted, and does a binary search. For a
+ * hashed table an exact match is a hash probe; an insertion position only makes sense
+ * in sorted order, so asking for one finalizes the table first.
  */
 long long Table::indexOf(KeySegment *key, bool matchOnly)
+{
+    if (hashIndex) {
+        if (matchOnly) return hashFind(key);
+        finalize();
+    }
+    KEY_SWITCH(keysize, searchKeys, (key, matchOnly));
+}
+
+
+template <int N>
+long long Table::searchKeys(KeySegment *key, bool matchOnly)
 {
     int compare;
     long long top = 0;
@@ -194,11 +304,11 @@ long long Table::indexOf(KeySegment *key, bool matchOnly)
     if (bottom < 0) return matchOnly ? -1 : 0;	// empty table
 
     // Handle ends of range first
-    compare = Key::compareKeys(KeyPtr(data, keysize, top), key, keysize);
+    compare = Key::FixedKeys<N>::compare(keyAt(top), key, keysize);
     if (compare == 0) return top;
     else if (compare > 0) return matchOnly ? -1 : 0;
 
-    compare = Key::compareKeys(KeyPtr(data, keysize, bottom), key, keysize);
+    compare = Key::FixedKeys<N>::compare(keyAt(bottom), key, keysize);
     if (compare == 0) return bottom;
     else if (compare < 0) return matchOnly ? -1 : tupleCount;
 
@@ -208,7 +318,7 @@ long long Table::indexOf(KeySegment *key, bool matchOnly)
     // Each iteration, the midpoint of the remaining range is checked, and
     // then half the keys are discarded.
     while (true) {
-        compare = Key::compareKeys(KeyPtr(data, keysize, mid), key, keysize);
+        compare = Key::FixedKeys<N>::compare(keyAt(mid), key, keysize);
         if (compare == 0) return mid;	// got a match
         if (compare > 0) {	// search top half of range
             bottom = mid;
@@ -216,7 +326,7 @@ long long Table::indexOf(KeySegment *key, bool matchOnly)
             top = mid;
         }
         if ((bottom - top) <= 1) return matchOnly ? -1 : bottom;	// no range left to search
-        mid = (bottom + top) / 2;
+        mid = (bottom + top) >> 1;	// a shift: gcc has compiled / 2 here to a slow idiv
     }
     return -1;	// this is never reached
 }
@@ -227,17 +337,397 @@ long long Table::indexOf(KeySegment *key, bool matchOnly)
  * the Unix QuickSort function qsort. We need a little adaptor function for the
  * comparator, because compareKeys isn't quite right
  */
-static int sortKeySize;	// must be set before calling sortCompare
+static thread_local int sortKeySize;	// must be set before calling sortCompare<0>
+template <int N>
 static int sortCompare(const void *k1, const void *k2)
 {
-    return Key::compareKeys((KeySegment *)k1, (KeySegment *)k2, sortKeySize);
+    return Key::FixedKeys<N>::compare((KeySegment *)k1, (KeySegment *)k2, sortKeySize);
+}
+
+
+typedef int (*SortCompare)(const void *k1, const void *k2);
+template <int N>
+static SortCompare sortCompareFor()
+{
+    return sortCompare<N>;
+}
+
+
+static SortCompare sortCompareFor(int keysize)
+{
+    KEY_SWITCH(keysize, sortCompareFor, ());
 }
 
 
 void Table::sort()
 {
+    hashDrop();
+    ownStorage();
     sortKeySize = keysize;
-    qsort(data, tupleCount, TupleBytes, sortCompare);
+    SortCompare compare = sortCompareFor(keysize);
+    if (layout == TableLayout::Columnar) {
+        char *packed = new char[TupleBytes * tupleCount];
+        packTuples(packed);
+        qsort(packed, tupleCount, TupleBytes, compare);
+        unpackTuples(packed);
+        delete [] packed;
+    } else {
+        qsort(data, tupleCount, TupleBytes, compare);
+    }
+}
+
+
+/**
+ * packTuples - copy the tuples into dest in the interleaved layout
+ */
+void Table::packTuples(char *dest)
+{
+    for (long long i = 0; i < tupleCount; i++) {
+        memcpy(KeyPtr(dest, keysize, i), keyAt(i), keysize * sizeof(KeySegment));
+        *ValuePtr(dest, keysize, i) = *valueAt(i);
+    }
+}
+
+
+/**
+ * unpackTuples - replace the tuples with those in src, which is in the interleaved layout
+ */
+void Table::unpackTuples(char *src)
+{
+    for (long long i = 0; i < tupleCount; i++) {
+        memcpy(keyAt(i), KeyPtr(src, keysize, i), keysize * sizeof(KeySegment));
+        *valueAt(i) = *ValuePtr(src, keysize, i);
+    }
+}
+
+
+/**
+ * Hash index support. Each slot of hashIndex holds a tuple index, or -1 if empty. Probing
+ * is linear, and the slot array is kept at most half full so probe chains stay short.
+ * Tuples are never removed while hashed, so no tombstones are needed.
+ */
+void Table::beginHashed()
+{
+    long long capacity = 16;
+    while (capacity < 2 * tupleCount + 2) capacity *= 2;
+    hashRebuild(capacity);
+}
+
+
+void Table::finalize()
+{
+    if (hashIndex) sort();
+}
+
+
+/**
+ * radixSortTuples - LSD radix sort of count tuples over the bytes of the packed key,
+ * ping-ponging between src and scratch; returns whichever buffer holds the result.
+ * Histograms for every byte position are gathered in one scan up front; byte positions
+ * which hold the same value in every key (unused bits, don't-care padding) are skipped.
+ * If a mask is given, only the bytes where it has zero bits (the relation's variables)
+ * can differ between keys, so the other bytes are not even histogrammed.
+ */
+static char *radixSortTuples(char *src, char *scratch, long long count, int keysize, KeySegment *mask)
+{
+    const int segBytes = sizeof(KeySegment);
+    const int keyBytes = keysize * segBytes;
+    const long long tupleBytes = TupleBytes;
+    if (count <= 1 || keyBytes <= 0) return src;
+
+    //-- byte positions which may vary, least significant first
+    std::vector<int> positions(keyBytes);
+    int positionCount = 0;
+    for (int s = keysize - 1; s >= 0; s--) {
+        for (int b = 0; b < segBytes; b++) {
+            if (mask && ((~mask[s] >> (8 * b)) & 0xff) == 0) continue;
+            positions[positionCount++] = s * segBytes + b;
+        }
+    }
+    if (positionCount == 0) return src;
+
+    long long *counts = new long long[positionCount * 256];
+    memset(counts, 0, positionCount * 256 * sizeof(long long));
+    for (long long i = 0; i < count; i++) {
+        KeySegment *key = (KeySegment*) (src + i * tupleBytes);
+        for (int p = 0; p < positionCount; p++) {
+            int pos = positions[p];
+            counts[p * 256 + ((key[pos / segBytes] >> (8 * (pos % segBytes))) & 0xff)]++;
+        }
+    }
+    long long offset[256];
+    for (int p = 0; p < positionCount; p++) {
+        long long *histogram = counts + p * 256;
+        bool trivial = false;
+        long long total = 0;
+        for (int v = 0; v < 256; v++) {
+            if (histogram[v] == count) trivial = true;
+            offset[v] = total;
+            total += histogram[v];
+        }
+        if (trivial) continue;
+        int s = positions[p] / segBytes;
+        int shift = 8 * (positions[p] % segBytes);
+        for (long long i = 0; i < count; i++) {
+            char *rec = src + i * tupleBytes;
+            int v = (((KeySegment*) rec)[s] >> shift) & 0xff;
+            memcpy(scratch + (offset[v]++) * tupleBytes, rec, tupleBytes);
+        }
+        char *tmp = src;
+        src = scratch;
+        scratch = tmp;
+    }
+    delete [] counts;
+    return src;
+}
+
+
+/**
+ * sortAndMerge - sort the tuples with a radix sort over the packed key, then collapse
+ * each run of equal keys into a single tuple holding the summed value.
+ */
+void Table::sortAndMerge()
+{
+    hashDrop();
+    ownStorage();
+    const long long tupleBytes = TupleBytes;
+    if (tupleCount > 1 && layout == TableLayout::Columnar) {
+        char *packed = new char[tupleBytes * tupleCount];
+        char *scratch = new char[tupleBytes * tupleCount];
+        packTuples(packed);
+        unpackTuples(radixSortTuples(packed, scratch, tupleCount, keysize, NULL));
+        delete [] packed;
+        delete [] scratch;
+    } else if (tupleCount > 1) {
+        char *scratch = new char[tupleBytes * maxTupleCount];
+        char *sorted = radixSortTuples((char*) data, scratch, tupleCount, keysize, NULL);
+        if (sorted == scratch) {
+            delete [] (char*) data;
+            data = sorted;
+        } else {
+            delete [] scratch;
+        }
+    }
+    KEY_SWITCH(keysize, mergeEqualKeys, ());
+}
+
+
+template <int N>
+void Table::mergeEqualKeys()
+{
+    long long out = 0;
+    for (long long i = 0; i < tupleCount; i++) {
+        KeySegment *key = keyAt(i);
+        if (out > 0 && Key::FixedKeys<N>::equal(keyAt(out - 1), key, keysize)) {
+            ocTupleValue *valuep = valueAt(out - 1);
+            double value = *valuep + *valueAt(i);
+            if (type == TableType::SetTheoretic && value != 0.0) value = 1.0;
+            *valuep = (ocTupleValue) value;
+        } else {
+            if (out != i) {
+                memcpy(keyAt(out), key, keysize * sizeof(KeySegment));
+                *valueAt(out) = *valueAt(i);
+            }
+            out++;
+        }
+    }
+    tupleCount = out;
+}
+
+
+/**
+ * groupBy - the tuples of from are masked into a per-thread scratch buffer, radix sorted
+ * on the relation's bytes only, and each run of equal keys is appended to this table as
+ * one summed tuple. The scratch buffers are kept between calls, since IPF projects the
+ * same size of table over and over, but only up to GROUP_SCRATCH_LIMIT bytes each; a
+ * larger table is summed through a hash index instead. from may be this table.
+ */
+void Table::groupBy(Table *from, KeySegment *mask)
+{
+    static thread_local char *scratch[2] = { NULL, NULL };
+    static thread_local long long scratchBytes = 0;
+    assert(from->keysize == keysize);
+    const long long tupleBytes = TupleBytes;
+    long long count = from->tupleCount;
+    long long bytes = count * tupleBytes;
+    if (bytes > GROUP_SCRATCH_LIMIT) {
+        Table *source = from;
+        if (from == this) {
+            source = new Table(keysize, count, type);
+            source->copy(this);
+        }
+        KeySegment *key = new KeySegment[keysize];
+        reset(keysize);
+        beginHashed();
+        for (long long i = 0; i < count; i++) {
+            Key::applyMask(key, source->keyAt(i), mask, keysize);
+            sumTuple(key, *source->valueAt(i));
+        }
+        finalize();
+        delete [] key;
+        if (source != from) delete source;
+        return;
+    }
+    if (bytes > scratchBytes) {
+        delete [] scratch[0];
+        delete [] scratch[1];
+        scratchBytes = bytes;
+        scratch[0] = new char[scratchBytes];
+        scratch[1] = new char[scratchBytes];
+    }
+    KEY_SWITCH(keysize, groupKeys, (scratch[0], scratch[1], from, mask));
+}
+
+
+template <int N>
+void Table::groupKeys(char *scratch, char *spare, Table *from, KeySegment *mask)
+{
+    long long count = from->tupleCount;
+    for (long long i = 0; i < count; i++) {
+        KeySegment *key = KeyPtr(scratch, keysize, i);
+        Key::FixedKeys<N>::applyMask(key, from->keyAt(i), mask, keysize);
+        *ValuePtr(scratch, keysize, i) = *from->valueAt(i);
+    }
+    char *sorted = radixSortTuples(scratch, spare, count, keysize, mask);
+
+    reset(keysize);
+    long long i = 0;
+    while (i < count) {
+        KeySegment *key = KeyPtr(sorted, keysize, i);
+        double value = *ValuePtr(sorted, keysize, i);
+        for (i++; i < count && Key::FixedKeys<N>::equal(KeyPtr(sorted, keysize, i), key, keysize); i++) {
+            value += *ValuePtr(sorted, keysize, i);
+        }
+        addTuple(key, value);
+    }
+}
+
+
+void Table::hashDrop()
+{
+    if (hashIndex) delete [] hashIndex;
+    hashIndex = NULL;
+    hashCapacity = 0;
+}
+
+
+void Table::hashRebuild(long long capacity)
+{
+    hashDrop();
+    hashIndex = new long long[capacity];
+    hashCapacity = capacity;
+    for (long long i = 0; i < capacity; i++) hashIndex[i] = -1;
+    for (long long i = 0; i < tupleCount; i++) {
+        long long slot = Key::hashKey(keyAt(i), keysize) & (hashCapacity - 1);
+        while (hashIndex[slot] >= 0) slot = (slot + 1) & (hashCapacity - 1);
+        hashIndex[slot] = i;
+    }
+}
+
+
+long long Table::hashFind(KeySegment *key)
+{
+    KEY_SWITCH(keysize, hashFindKeys, (key));
+}
+
+
+template <int N>
+long long Table::hashFindKeys(KeySegment *key)
+{
+    long long slot = Key::hashKey(key, keysize) & (hashCapacity - 1);
+    while (true) {
+        long long index = hashIndex[slot];
+        if (index < 0) return -1;
+        if (Key::FixedKeys<N>::equal(keyAt(index), key, keysize)) return index;
+        slot = (slot + 1) & (hashCapacity - 1);
+    }
+}
+
+
+void Table::hashInsert(long long index)
+{
+    if (2 * tupleCount >= hashCapacity) {
+        hashRebuild(hashCapacity * 2);  // rebuild indexes every tuple, including this one
+        return;
+    }
+    long long slot = Key::hashKey(keyAt(index), keysize) & (hashCapacity - 1);
+    while (hashIndex[slot] >= 0) slot = (slot + 1) & (hashCapacity - 1);
+    hashIndex[slot] = index;
+}
+
+
+void Table::attachMapped(void *base, size_t length, void *tuples, long long count)
+{
+    if (mapBase) munmap(mapBase, mapLength);
+    else if (data) delete [] (char*)data;
+    if (values) delete [] (char*)values;
+    values = NULL;
+    layout = TableLayout::Interleaved;
+    hashDrop();
+    mapBase = base;
+    mapLength = length;
+    data = tuples;
+    normalTuples = NULL;
+    tupleCount = maxTupleCount = count;
+}
+
+
+void Table::attachNormalized(void *tuples, double sum)
+{
+    normalTuples = tuples;
+    normalSum = sum;
+}
+
+
+/**
+ * ownStorage - a mapped table moves its tuples into ordinary storage, which can grow
+ * and be changed
+ */
+void Table::ownStorage()
+{
+    if (mapBase == NULL) return;
+    normalTuples = NULL;
+    if (maxTupleCount < 1) maxTupleCount = 1;
+    char *own = new char[TupleBytes * maxTupleCount];
+    memcpy(own, data, TupleBytes * tupleCount);
+    munmap(mapBase, mapLength);
+    mapBase = NULL;
+    mapLength = 0;
+    data = own;
+}
+
+
+/**
+ * reserve - make room for at least count tuples
+ */
+void Table::reserve(long long count)
+{
+    if (count <= maxTupleCount) return;
+    ownStorage();
+    while (count > maxTupleCount) {
+        if (layout == TableLayout::Columnar) {
+            data = growStorage(data, maxTupleCount*keysize*sizeof(KeySegment), GROWTH_FACTOR);
+            values = (ocTupleValue*) growStorage(values, maxTupleCount*sizeof(ocTupleValue), GROWTH_FACTOR);
+        } else {
+            data = growStorage(data, maxTupleCount*TupleBytes, GROWTH_FACTOR);
+        }
+        maxTupleCount *= GROWTH_FACTOR;
+    }
+}
+
+
+/**
+ * eachValue - apply action to a reference to each value in turn. For a columnar table
+ * this is a loop over a plain array, which the compiler can vectorize.
+ */
+template <typename F>
+void Table::eachValue(F action)
+{
+    if (layout == TableLayout::Columnar) {
+        for (long long i = 0; i < tupleCount; i++) action(values[i]);
+    } else {
+        for (long long i = 0; i < tupleCount; i++) action(*ValuePtr(data, keysize, i));
+    }
 }
 
 
@@ -246,14 +736,15 @@ void Table::sort()
  */
 double Table::normalize()
 {
-    double denom = 0;
-    long long i;
-    for (i = 0; i < tupleCount; i++) {
-        denom += getValue(i);
-    }
-    for (i = 0; i < tupleCount; i++) {
-        setValue(i, (getValue(i)/denom));
+    if (normalTuples) {
+        data = normalTuples;
+        normalTuples = NULL;
+        return normalSum;
     }
+    ownStorage();
+    double denom = 0;
+    eachValue([&](ocTupleValue &value) { denom += value; });
+    eachValue([&](ocTupleValue &value) { value = value / denom; });
     //-- if the data was already normalized, then not much will have happened.
     //-- but in that case there is no sample size info, so return 1.
     //if (denom < 1.5) return 1;
@@ -265,10 +756,8 @@ double Table::normalize()
 // Adds a constant to every value in the table.
 void Table::addConstant(double constant)
 {
-    long long i;
-    for (i = 0; i < tupleCount; i++) {
-        setValue(i, getValue(i) + constant);
-    }
+    ownStorage();
+    eachValue([&](ocTupleValue &value) { value = value + constant; });
 }
 
 
@@ -276,10 +765,10 @@ void Table::addConstant(double constant)
 double Table::getLowestValue()
 {
     double lowest = getValue(0);
-    for (long long i = 0; i < tupleCount; i++) {
-        if (getValue(i) < lowest)
-            lowest = getValue(i);
-    }
+    eachValue([&](ocTupleValue &value) {
+        if (value < lowest)
+            lowest = value;
+    });
     return lowest;
 }
 
@@ -289,7 +778,9 @@ double Table::getLowestValue()
  */
 void Table::reset(int keysize)
 {
+    hashDrop();
     this->tupleCount = 0;
+    ownStorage();
     this->keysize = keysize;
 }
 
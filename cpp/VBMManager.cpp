@@ -603,12 +603,10 @@ double VBMManager::computeBPT(Model *model) {
                     //-- get the orthogonal dimension of the relation (the number of states projected into one substate)
                     double relDimension = fullDimension / (ocDegreesOfFreedom(rel) + 1);
                     //-- add the scaled contribution to each q
+                    KeySegment *mask = rel->getMask();
                     for (int i = 0; i < qData->getTupleCount(); i++) {
-                        qData->copyKey(i, key);
                         q = qData->getValue(i);
-                        KeySegment *mask = rel->getMask();
-                        for (int k = 0; k < keysize; k++)
-                            key[k] |= mask[k];
+                        Key::applyMask(key, qData->getKey(i), mask, keysize);
                         int j = rel->getTable()->indexOf(key);
                         if (j >= 0) {
                             qi = (sign ? 1 : -1) * (rel->getTable()->getValue(j) / relDimension);
@@ -34,6 +34,16 @@ static void normalizeCase(char *cp) {
     }
 }
 
+//-- FNV-1a hash of a value string, for the value map index
+static unsigned int hashValue(const char *value) {
+    unsigned int h = 2166136261u;
+    while (*value) {
+        h ^= (unsigned char) *value++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
 VariableList::VariableList(int maxVars) {
     //const int MAX_MASK = 4;  // max number of variables = this * (bits in a long)
     maxVarCount = maxVars;
@@ -55,9 +65,15 @@ VariableList::VariableList(int maxVars) {
 VariableList::~VariableList() {
     for (int i = 0; i < varCount; i++) {
         Variable *varp = vars + i;
-        for (int j = 0; j < varp->cardinality; j++) {
-            delete varp->valmap[j];
+        for (int j = 0; j < varp->valueCount; j++) {
+            delete[] varp->valmap[j];
         }
+        delete[] varp->valmap;
+        delete[] varp->valueSlots;
+        delete[] varp->oldnew[0];
+        delete[] varp->oldnew[1];
+        delete[] varp->rebinSlots;
+        delete[] varp->rebinIndices;
         if (varp->exclude)
             delete[] varp->exclude;
     }
@@ -68,7 +84,13 @@ VariableList::~VariableList() {
 }
 
 long VariableList::size() {
-    return maxVarCount * sizeof(Variable) + sizeof(VariableList);
+    long mapSize = 0;
+    for (int i = 0; i < varCount; i++) {
+        mapSize += (1 << vars[i].size) * sizeof(char*) + vars[i].valueSlotCount * sizeof(int);
+        mapSize += 2 * vars[i].oldnewSize * sizeof(char*);
+        mapSize += vars[i].rebinSlotCount * sizeof(int) + (vars[i].rebinIndices ? vars[i].oldnewSize * sizeof(int) : 0);
+    }
+    return maxVarCount * sizeof(Variable) + mapSize + sizeof(VariableList);
 }
 
 /*
@@ -131,12 +153,50 @@ int VariableList::addVariable(const char *name, const char *abbrev, int cardinal
     KeySegment keytemp = 1;
     varp->mask = ((keytemp << varp->size) - 1) << varp->shift; // 1's in the var positions
 
-    // clear the value map
-    memset(varp->valmap, 0, MAXCARDINALITY * sizeof(const char *));
+    //-- the value map holds at most cardinality values, but has an entry (NULL if unused)
+    //-- for every value the variable's bits in a key can take, DONT_CARE included. Its
+    //-- hash index is kept at most half full, so probe chains stay short.
+    varp->valmap = new char*[1 << varp->size];
+    memset(varp->valmap, 0, (1 << varp->size) * sizeof(char*));
+    varp->valueCount = 0;
+    varp->valueSlotCount = 4;
+    while (varp->valueSlotCount < 2 * varp->cardinality)
+        varp->valueSlotCount *= 2;
+    varp->valueSlots = new int[varp->valueSlotCount];
+    for (int i = 0; i < varp->valueSlotCount; i++)
+        varp->valueSlots[i] = -1;
+    varp->oldnew[0] = varp->oldnew[1] = NULL;
+    varp->oldnewSize = 0;
+    varp->rebinSlots = varp->rebinIndices = NULL;
+    varp->rebinSlotCount = 0;
+    varp->rebinDefault = DISCARD;
 
     return 0;
 }
 
+/*
+ * growRebinMap - the rebinning map is filled in entry by entry as the rebinning string
+ * is parsed, so it is grown on demand
+ */
+void VariableList::growRebinMap(int varindex, int count) {
+    Variable *varp = vars + varindex;
+    if (count <= varp->oldnewSize)
+        return;
+    int size = varp->oldnewSize > 0 ? varp->oldnewSize : 8;
+    while (size < count)
+        size *= 2;
+    for (int row = 0; row < 2; row++) {
+        char **entries = new char*[size];
+        memset(entries, 0, size * sizeof(char*));
+        if (varp->oldnew[row]) {
+            memcpy(entries, varp->oldnew[row], varp->oldnewSize * sizeof(char*));
+            delete[] varp->oldnew[row];
+        }
+        varp->oldnew[row] = entries;
+    }
+    varp->oldnewSize = size;
+}
+
 /*
  * isVarInUse - checks if the variable's value has to be ignored since it is marked as of
  * type 0. Returns 0 if the variable is marked (that is to be ignored), returns 1 for good.
@@ -202,6 +262,89 @@ int VariableList::getNewValue(int index, char * old_value, char*new_value) {
     return -1;
 }
 
+/*
+ * compileRebin - build the hash getRebinRule probes. A rebinning map is a list of
+ * (old, new) entries, the first match winning, and possibly ending with an entry for
+ * "*", which matches everything else. An exclude value is compiled as a map with only
+ * that value, discarded, and everything else kept.
+ */
+void VariableList::compileRebin(int varindex) {
+    Variable *varp = vars + varindex;
+    int count = 0;
+    if (varp->rebin && varp->oldnew[NEW_ROW]) {
+        while (varp->oldnew[NEW_ROW][count] != NULL)
+            count++;
+    }
+    delete[] varp->rebinSlots;
+    delete[] varp->rebinIndices;
+    varp->rebinSlotCount = 4;
+    while (varp->rebinSlotCount < 2 * (count + 1))
+        varp->rebinSlotCount *= 2;
+    varp->rebinSlots = new int[varp->rebinSlotCount];
+    for (int i = 0; i < varp->rebinSlotCount; i++)
+        varp->rebinSlots[i] = -1;
+    varp->rebinIndices = new int[count > 0 ? count : 1];
+    int mask = varp->rebinSlotCount - 1;
+    if (varp->exclude != NULL) {
+        //-- slot entry 0 stands for the exclude value
+        varp->rebinSlots[hashValue(varp->exclude) & mask] = 0;
+        varp->rebinDefault = REBIN_KEEP;
+        return;
+    }
+    varp->rebinDefault = DISCARD;
+    for (int rule = 0; rule < count; rule++) {
+        varp->rebinIndices[rule] = -1;
+        const char *old = varp->oldnew[OLD_ROW][rule];
+        if (strcmp(old, "*") == 0) {
+            varp->rebinDefault = rule;
+            break;
+        }
+        int slot = hashValue(old) & mask;
+        int index;
+        while ((index = varp->rebinSlots[slot]) >= 0 && strcmp(varp->oldnew[OLD_ROW][index], old) != 0)
+            slot = (slot + 1) & mask;
+        if (index < 0)
+            varp->rebinSlots[slot] = rule;
+    }
+}
+
+int VariableList::getRebinRule(int varindex, const char *value) {
+    Variable *varp = vars + varindex;
+    char myvalue[101];
+    int chr;
+    //-- the value text, as getNewValue extracts it
+    for (chr = 0; chr < 100; chr++) {
+        if (value[chr] == '\0' || isspace(value[chr]) || (value[chr] == ','))
+            break;
+        else
+            myvalue[chr] = value[chr];
+    }
+    myvalue[chr] = '\0';
+    int mask = varp->rebinSlotCount - 1;
+    int slot = hashValue(myvalue) & mask;
+    int index;
+    while ((index = varp->rebinSlots[slot]) >= 0) {
+        if (varp->exclude != NULL) {
+            if (strcmp(myvalue, varp->exclude) == 0)
+                return DISCARD;
+        } else if (strcmp(myvalue, varp->oldnew[OLD_ROW][index]) == 0) {
+            return index;
+        }
+        slot = (slot + 1) & mask;
+    }
+    //-- an empty value (a short line) is never kept as it is
+    if (varp->rebinDefault == REBIN_KEEP && chr == 0)
+        return DISCARD;
+    return varp->rebinDefault;
+}
+
+int VariableList::getRebinValueIndex(int varindex, int rule) {
+    int *index = vars[varindex].rebinIndices + rule;
+    if (*index < 0)
+        *index = getVarValueIndex(varindex, getRebinValue(varindex, rule));
+    return *index;
+}
+
 /**
  * getKeySize - return the number of required segments for a key.  This is determined
  * by just looking at the last variable
@@ -398,11 +541,9 @@ int VariableList::getVarStateList(const char *name, int *varlist, int *stlist) {
 }
 
 int VariableList::getVarValueIndex(int varindex, const char *value) {
-    int index = 0;
-    char **map = vars[varindex].valmap;
+    Variable *varp = vars + varindex;
     char myvalue[100];
     int chr;
-    int cardinality = vars[varindex].cardinality;
     //-- extract the name as a separate string
     for (chr = 0; chr < 100; chr++) {
         if (value[chr] == '\0' || isspace(value[chr]) || (value[chr] == ','))
@@ -411,18 +552,21 @@ int VariableList::getVarValueIndex(int varindex, const char *value) {
             myvalue[chr] = value[chr];
     }
     myvalue[chr] = '\0';
-    //-- find this value in the value map. Stop on first empty entry
-    while (index < cardinality) {
-        if (map[index] == NULL)
-            break;
-        if (strcmp(myvalue, map[index]) == 0)
+    //-- find this value in the value map, through its hash index
+    int mask = varp->valueSlotCount - 1;
+    int slot = hashValue(myvalue) & mask;
+    int index;
+    while ((index = varp->valueSlots[slot]) >= 0) {
+        if (strcmp(myvalue, varp->valmap[index]) == 0)
             return index;
-        index++;
+        slot = (slot + 1) & mask;
     }
     //-- if we have room, add this value. Otherwise return error.
-    if (index < cardinality) {
-        map[index] = new char[strlen(value) + 1];
-        strcpy(map[index], myvalue);
+    if (varp->valueCount < varp->cardinality) {
+        index = varp->valueCount++;
+        varp->valmap[index] = new char[chr + 1];
+        strcpy(varp->valmap[index], myvalue);
+        varp->valueSlots[slot] = index;
         return index;
     } else
         return -1;
@@ -441,10 +585,7 @@ bool VariableList::checkCardinalities() {
     bool result = true;
     for (int varindex = 0; varindex < varCount; varindex++) {
         int cardinality = vars[varindex].cardinality;
-        char **map = vars[varindex].valmap;
-        int valuecount = 0;
-        while (map[valuecount] != NULL)
-            valuecount++;
+        int valuecount = vars[varindex].valueCount;
         if (valuecount < cardinality) {
             printf(
                     "Warning: input data cardinality for variable %s (%s) is %d, but was specified as %d. The lower value will be used.\n",
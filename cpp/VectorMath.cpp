@@ -0,0 +1,297 @@
+/*
+ * Copyright © 1990 The Portland State University OCCAM Project Team
+ * [This program is licensed under the GPL version 3 or later.]
+ * Please see the file LICENSE in the source
+ * distribution of this software for license terms.
+ */
+
+#include "VectorMath.h"
+#include "Constants.h"
+
+#include <immintrin.h>
+#include <string.h>
+
+/*
+ * Constants for the fdlibm log. A value is split into 2^k * m with m in
+ * [sqrt(2)/2, sqrt(2)); with f = m - 1 and s = f / (2 + f), log(m) is
+ * f - hfsq + s * (hfsq + R(s^2)), where R is a polynomial in s^2. ln 2 is split
+ * in two so k * LN2_HI is exact.
+ */
+static const double LN2_HI = 6.93147180369123816490e-01;
+static const double LN2_LO = 1.90821492927058770002e-10;
+static const double SQRT2 = 1.41421356237309504880;
+static const double LG1 = 6.666666666666735130e-01;
+static const double LG2 = 3.999999999940941908e-01;
+static const double LG3 = 2.857142874366239149e-01;
+static const double LG4 = 2.222219843214978396e-01;
+static const double LG5 = 1.818357216161805012e-01;
+static const double LG6 = 1.531383769920937332e-01;
+static const double LG7 = 1.479819860511658591e-01;
+
+//-- values are processed in groups of four, the width of one AVX2 register or two SSE2
+//-- registers; a short last group is padded with entries which contribute nothing
+static const int GROUP = 4;
+
+
+//-- SSE2 versions. Each group is two registers, holding lanes 0-1 and 2-3.
+
+static inline __m128d selectSSE2(__m128d mask, __m128d a, __m128d b)
+{
+    return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b)); // mask ? a : b
+}
+
+static inline __m128d logSSE2(__m128d x)
+{
+    const __m128d one = _mm_set1_pd(1.0);
+    __m128i bits = _mm_castpd_si128(x);
+    __m128i exponent = _mm_srli_epi64(bits, 52);
+    __m128d k = _mm_sub_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(exponent, _MM_SHUFFLE(3, 3, 2, 0))),
+            _mm_set1_pd(1023.0));
+    __m128d m = _mm_castsi128_pd(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi64x(0x000fffffffffffffLL)),
+            _mm_set1_epi64x(0x3ff0000000000000LL)));
+    __m128d big = _mm_cmpgt_pd(m, _mm_set1_pd(SQRT2));
+    m = selectSSE2(big, _mm_mul_pd(m, _mm_set1_pd(0.5)), m);
+    k = _mm_add_pd(k, _mm_and_pd(big, one));
+
+    __m128d f = _mm_sub_pd(m, one);
+    __m128d hfsq = _mm_mul_pd(_mm_set1_pd(0.5), _mm_mul_pd(f, f));
+    __m128d s = _mm_div_pd(f, _mm_add_pd(_mm_set1_pd(2.0), f));
+    __m128d z = _mm_mul_pd(s, s);
+    __m128d w = _mm_mul_pd(z, z);
+    __m128d t1 = _mm_mul_pd(w, _mm_add_pd(_mm_set1_pd(LG2), _mm_mul_pd(w, _mm_add_pd(_mm_set1_pd(LG4),
+            _mm_mul_pd(w, _mm_set1_pd(LG6))))));
+    __m128d t2 = _mm_mul_pd(z, _mm_add_pd(_mm_set1_pd(LG1), _mm_mul_pd(w, _mm_add_pd(_mm_set1_pd(LG3),
+            _mm_mul_pd(w, _mm_add_pd(_mm_set1_pd(LG5), _mm_mul_pd(w, _mm_set1_pd(LG7))))))));
+    __m128d r = _mm_add_pd(t2, t1);
+    __m128d inner = _mm_add_pd(_mm_mul_pd(s, _mm_add_pd(hfsq, r)), _mm_mul_pd(k, _mm_set1_pd(LN2_LO)));
+    return _mm_sub_pd(_mm_mul_pd(k, _mm_set1_pd(LN2_HI)), _mm_sub_pd(_mm_sub_pd(hfsq, inner), f));
+}
+
+static inline __m128d termSSE2(__m128d p)
+{
+    __m128d mask = _mm_cmpgt_pd(p, _mm_set1_pd(PROB_MIN));
+    __m128d x = selectSSE2(mask, p, _mm_set1_pd(1.0));
+    return _mm_and_pd(mask, _mm_mul_pd(p, logSSE2(x)));
+}
+
+static inline __m128d termSSE2(__m128d p, __m128d q)
+{
+    const __m128d one = _mm_set1_pd(1.0);
+    __m128d mask = _mm_and_pd(_mm_cmpgt_pd(p, _mm_set1_pd(PROB_MIN)), _mm_cmpgt_pd(q, _mm_set1_pd(PROB_MIN)));
+    __m128d x = selectSSE2(mask, _mm_div_pd(p, selectSSE2(mask, q, one)), one);
+    return _mm_and_pd(mask, _mm_mul_pd(p, logSSE2(x)));
+}
+
+static double sumSSE2(__m128d acc0, __m128d acc1)
+{
+    double lanes[GROUP];
+    _mm_storeu_pd(lanes, acc0);
+    _mm_storeu_pd(lanes + 2, acc1);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+static double sumPLogPSSE2(const double *p, long long n)
+{
+    __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    long long i = 0;
+    for (; i + GROUP <= n; i += GROUP) {
+        acc0 = _mm_add_pd(acc0, termSSE2(_mm_loadu_pd(p + i)));
+        acc1 = _mm_add_pd(acc1, termSSE2(_mm_loadu_pd(p + i + 2)));
+    }
+    if (i < n) {
+        double pp[GROUP] = { 0, 0, 0, 0 };
+        memcpy(pp, p + i, (n - i) * sizeof(double));
+        acc0 = _mm_add_pd(acc0, termSSE2(_mm_loadu_pd(pp)));
+        acc1 = _mm_add_pd(acc1, termSSE2(_mm_loadu_pd(pp + 2)));
+    }
+    return sumSSE2(acc0, acc1);
+}
+
+static double sumPLogPQSSE2(const double *p, const double *q, long long n)
+{
+    __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    long long i = 0;
+    for (; i + GROUP <= n; i += GROUP) {
+        acc0 = _mm_add_pd(acc0, termSSE2(_mm_loadu_pd(p + i), _mm_loadu_pd(q + i)));
+        acc1 = _mm_add_pd(acc1, termSSE2(_mm_loadu_pd(p + i + 2), _mm_loadu_pd(q + i + 2)));
+    }
+    if (i < n) {
+        double pp[GROUP] = { 0, 0, 0, 0 }, qq[GROUP] = { 0, 0, 0, 0 };
+        memcpy(pp, p + i, (n - i) * sizeof(double));
+        memcpy(qq, q + i, (n - i) * sizeof(double));
+        acc0 = _mm_add_pd(acc0, termSSE2(_mm_loadu_pd(pp), _mm_loadu_pd(qq)));
+        acc1 = _mm_add_pd(acc1, termSSE2(_mm_loadu_pd(pp + 2), _mm_loadu_pd(qq + 2)));
+    }
+    return sumSSE2(acc0, acc1);
+}
+
+static void logArraySSE2(const double *x, double *out, long long n)
+{
+    long long i = 0;
+    for (; i + 2 <= n; i += 2) {
+        _mm_storeu_pd(out + i, logSSE2(_mm_loadu_pd(x + i)));
+    }
+    if (i < n) {
+        double xx[2] = { x[i], 1.0 }, yy[2];
+        _mm_storeu_pd(yy, logSSE2(_mm_loadu_pd(xx)));
+        out[i] = yy[0];
+    }
+}
+
+
+//-- AVX2 versions; the same operations as above, four lanes to a register. FMA is
+//-- deliberately not enabled, since fusing would round differently from SSE2.
+
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static inline __m256d logAVX2(__m256d x)
+{
+    const __m256d one = _mm256_set1_pd(1.0);
+    __m256i bits = _mm256_castpd_si256(x);
+    __m256i exponent = _mm256_srli_epi64(bits, 52);
+    __m128i packed = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(exponent,
+            _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6)));
+    __m256d k = _mm256_sub_pd(_mm256_cvtepi32_pd(packed), _mm256_set1_pd(1023.0));
+    __m256d m = _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits,
+            _mm256_set1_epi64x(0x000fffffffffffffLL)), _mm256_set1_epi64x(0x3ff0000000000000LL)));
+    __m256d big = _mm256_cmp_pd(m, _mm256_set1_pd(SQRT2), _CMP_GT_OQ);
+    m = _mm256_blendv_pd(m, _mm256_mul_pd(m, _mm256_set1_pd(0.5)), big);
+    k = _mm256_add_pd(k, _mm256_and_pd(big, one));
+
+    __m256d f = _mm256_sub_pd(m, one);
+    __m256d hfsq = _mm256_mul_pd(_mm256_set1_pd(0.5), _mm256_mul_pd(f, f));
+    __m256d s = _mm256_div_pd(f, _mm256_add_pd(_mm256_set1_pd(2.0), f));
+    __m256d z = _mm256_mul_pd(s, s);
+    __m256d w = _mm256_mul_pd(z, z);
+    __m256d t1 = _mm256_mul_pd(w, _mm256_add_pd(_mm256_set1_pd(LG2), _mm256_mul_pd(w,
+            _mm256_add_pd(_mm256_set1_pd(LG4), _mm256_mul_pd(w, _mm256_set1_pd(LG6))))));
+    __m256d t2 = _mm256_mul_pd(z, _mm256_add_pd(_mm256_set1_pd(LG1), _mm256_mul_pd(w,
+            _mm256_add_pd(_mm256_set1_pd(LG3), _mm256_mul_pd(w, _mm256_add_pd(_mm256_set1_pd(LG5),
+            _mm256_mul_pd(w, _mm256_set1_pd(LG7))))))));
+    __m256d r = _mm256_add_pd(t2, t1);
+    __m256d inner = _mm256_add_pd(_mm256_mul_pd(s, _mm256_add_pd(hfsq, r)),
+            _mm256_mul_pd(k, _mm256_set1_pd(LN2_LO)));
+    return _mm256_sub_pd(_mm256_mul_pd(k, _mm256_set1_pd(LN2_HI)), _mm256_sub_pd(_mm256_sub_pd(hfsq, inner), f));
+}
+
+AVX2 static inline __m256d termAVX2(__m256d p)
+{
+    __m256d mask = _mm256_cmp_pd(p, _mm256_set1_pd(PROB_MIN), _CMP_GT_OQ);
+    __m256d x = _mm256_blendv_pd(_mm256_set1_pd(1.0), p, mask);
+    return _mm256_and_pd(mask, _mm256_mul_pd(p, logAVX2(x)));
+}
+
+AVX2 static inline __m256d termAVX2(__m256d p, __m256d q)
+{
+    const __m256d one = _mm256_set1_pd(1.0);
+    __m256d mask = _mm256_and_pd(_mm256_cmp_pd(p, _mm256_set1_pd(PROB_MIN), _CMP_GT_OQ),
+            _mm256_cmp_pd(q, _mm256_set1_pd(PROB_MIN), _CMP_GT_OQ));
+    __m256d x = _mm256_blendv_pd(one, _mm256_div_pd(p, _mm256_blendv_pd(one, q, mask)), mask);
+    return _mm256_and_pd(mask, _mm256_mul_pd(p, logAVX2(x)));
+}
+
+AVX2 static double sumAVX2(__m256d acc)
+{
+    double lanes[GROUP];
+    _mm256_storeu_pd(lanes, acc);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+AVX2 static double sumPLogPAVX2(const double *p, long long n)
+{
+    __m256d acc = _mm256_setzero_pd();
+    long long i = 0;
+    for (; i + GROUP <= n; i += GROUP) {
+        acc = _mm256_add_pd(acc, termAVX2(_mm256_loadu_pd(p + i)));
+    }
+    if (i < n) {
+        double pp[GROUP] = { 0, 0, 0, 0 };
+        memcpy(pp, p + i, (n - i) * sizeof(double));
+        acc = _mm256_add_pd(acc, termAVX2(_mm256_loadu_pd(pp)));
+    }
+    return sumAVX2(acc);
+}
+
+AVX2 static double sumPLogPQAVX2(const double *p, const double *q, long long n)
+{
+    __m256d acc = _mm256_setzero_pd();
+    long long i = 0;
+    for (; i + GROUP <= n; i += GROUP) {
+        acc = _mm256_add_pd(acc, termAVX2(_mm256_loadu_pd(p + i), _mm256_loadu_pd(q + i)));
+    }
+    if (i < n) {
+        double pp[GROUP] = { 0, 0, 0, 0 }, qq[GROUP] = { 0, 0, 0, 0 };
+        memcpy(pp, p + i, (n - i) * sizeof(double));
+        memcpy(qq, q + i, (n - i) * sizeof(double));
+        acc = _mm256_add_pd(acc, termAVX2(_mm256_loadu_pd(pp), _mm256_loadu_pd(qq)));
+    }
+    return sumAVX2(acc);
+}
+
+AVX2 static void logArrayAVX2(const double *x, double *out, long long n)
+{
+    long long i = 0;
+    for (; i + GROUP <= n; i += GROUP) {
+        _mm256_storeu_pd(out + i, logAVX2(_mm256_loadu_pd(x + i)));
+    }
+    if (i < n) {
+        double xx[GROUP] = { 1.0, 1.0, 1.0, 1.0 }, yy[GROUP];
+        memcpy(xx, x + i, (n - i) * sizeof(double));
+        _mm256_storeu_pd(yy, logAVX2(_mm256_loadu_pd(xx)));
+        memcpy(out + i, yy, (n - i) * sizeof(double));
+    }
+}
+
+
+//-- run-time dispatch
+
+struct VectorKernels {
+    const char *name;
+    double (*sumPLogP)(const double *p, long long n);
+    double (*sumPLogPQ)(const double *p, const double *q, long long n);
+    void (*logArray)(const double *x, double *out, long long n);
+};
+
+static const VectorKernels sse2Kernels = { "sse2", sumPLogPSSE2, sumPLogPQSSE2, logArraySSE2 };
+static const VectorKernels avx2Kernels = { "avx2", sumPLogPAVX2, sumPLogPQAVX2, logArrayAVX2 };
+
+static bool hasAVX2()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+static const VectorKernels *activeKernels = hasAVX2() ? &avx2Kernels : &sse2Kernels;
+
+
+double ocSumPLogP(const double *p, long long n)
+{
+    return activeKernels->sumPLogP(p, n);
+}
+
+double ocSumPLogPQ(const double *p, const double *q, long long n)
+{
+    return activeKernels->sumPLogPQ(p, q, n);
+}
+
+void ocLogArray(const double *x, double *out, long long n)
+{
+    activeKernels->logArray(x, out, n);
+}
+
+const char *ocVectorISA()
+{
+    return activeKernels->name;
+}
+
+bool ocUseVectorISA(const char *name)
+{
+    if (strcmp(name, "sse2") == 0) {
+        activeKernels = &sse2Kernels;
+    } else if (strcmp(name, "avx2") == 0 && hasAVX2()) {
+        activeKernels = &avx2Kernels;
+    } else {
+        return false;
+    }
+    return true;
+}
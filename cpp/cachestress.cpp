@@ -0,0 +1,94 @@
+/*
+ * Copyright © 1990 The Portland State University OCCAM Project Team
+ * [This program is licensed under the GPL version 3 or later.]
+ * Please see the file LICENSE in the source
+ * distribution of this software for license terms.
+ */
+
+/*
+ * cachestress - exercises CacheTable (under RelCache and ModelCache) from several threads
+ * at once: readers look up names which stay in the table while writers add and remove
+ * others in the same shards, deleting each object as soon as it is removed. Build with
+ * "make cachestress", which uses ThreadSanitizer; any report from it is a failure.
+ *
+ *     cachestress [threads] [rounds]
+ */
+
+#include "CacheTable.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+//-- a cached object; its name lives inside it, so reading it after delete is a use-after-free
+struct Item {
+    char name[32];
+    Item(const char *prefix, int n) {
+        snprintf(name, sizeof(name), "%s%d", prefix, n);
+    }
+    const char *getPrintName() {
+        return name;
+    }
+};
+
+int main(int argc, char* argv[]) {
+    int threads = argc > 1 ? atoi(argv[1]) : 8;
+    int rounds = argc > 2 ? atoi(argv[2]) : 20000;
+    if (threads < 2 || rounds <= 0) {
+        printf("usage: %s [threads (at least 2)] [rounds]\n", argv[0]);
+        return 1;
+    }
+    const int KEPT = 4096;
+    CacheTable<Item> table;
+    std::vector<Item*> kept;
+    for (int i = 0; i < KEPT; i++) {
+        kept.push_back(new Item("kept", i));
+        table.findOrAdd(kept.back());
+    }
+    std::atomic<long> errors(0);
+    std::atomic<long> duplicates(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.push_back(std::thread([&, t]() {
+            for (int r = 0; r < rounds; r++) {
+                if (t % 2 == 0) {
+                    //-- writer: add an object (racing another writer for the same name),
+                    //-- then remove and delete it
+                    Item *item = new Item("temp", (r * 31 + t / 2) % 1024);
+                    Item *cached = table.findOrAdd(item);
+                    if (cached != item) {
+                        duplicates++;
+                        delete item;
+                    } else if (!table.remove(item)) {
+                        errors++;
+                    } else {
+                        delete item;
+                    }
+                } else {
+                    //-- reader: every kept object must always be found, and looking for
+                    //-- the writers' objects must be safe whether or not they are there
+                    Item *want = kept[(r * 7 + t) % KEPT];
+                    if (table.find(want->getPrintName()) != want)
+                        errors++;
+                    char name[32];
+                    snprintf(name, sizeof(name), "temp%d", (r * 17 + t) % 1024);
+                    table.find(name);
+                }
+            }
+        }));
+    }
+    for (size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+    long count = 0;
+    table.forEach([&](Item *item) {
+        count++;
+    });
+    if (count != KEPT)
+        errors++;
+    printf("%d threads, %d rounds: %ld lookup or removal errors, %ld adds lost to a race, %ld objects left %s\n",
+            threads, rounds, errors.load(), duplicates.load(), count, errors == 0 ? "ok" : "FAILED");
+    for (int i = 0; i < KEPT; i++)
+        delete kept[i];
+    return errors == 0 ? 0 : 1;
+}
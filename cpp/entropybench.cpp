@@ -0,0 +1,161 @@
+/*
+ * Copyright © 1990 The Portland State University OCCAM Project Team
+ * [This program is licensed under the GPL version 3 or later.]
+ * Please see the file LICENSE in the source
+ * distribution of this software for license terms.
+ */
+
+/*
+ * entropybench - checks the vector log against libm's and times ocEntropy and
+ * ocTransmission with the SSE2 and AVX2 kernels against the scalar loops they replaced.
+ * Build with "make entropybench".
+ *
+ *     entropybench [tuples]
+ *
+ * The tables are random distributions of the given size (default 1000000). Differences
+ * from the scalar sums are reported relative to the sum; the SSE2 and AVX2 sums should
+ * be identical.
+ */
+
+#include "Math.h"
+#include "Table.h"
+#include "VectorMath.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+//-- the loops ocEntropy and ocTransmission used before the vector kernels
+static double scalarEntropy(Table *p) {
+    double h = 0.0;
+    long long count = p->getTupleCount();
+    for (long long i = 0; i < count; ++i) {
+        double pv = p->getValue(i);
+        if (pv > PROB_MIN)
+            h -= pv * log(pv);
+    }
+    return h / log(2.0);
+}
+
+static double scalarTransmission(Table *p, Table *q) {
+    double h = 0.0;
+    long long count = p->getTupleCount();
+    for (long long i = 0; i < count; ++i) {
+        double pv = p->getValue(i);
+        long long j = q->indexOf(p->getKey(i));
+        double qv = j >= 0 ? q->getValue(j) : 0.0;
+        if (qv > PROB_MIN && pv > PROB_MIN)
+            h += pv * log(pv / qv);
+    }
+    return h / log(2.0);
+}
+
+//-- a random distribution over keys 0..count-1; about one value in eight is zero
+static Table *makeTable(long long count, unsigned int seed) {
+    Table *table = new Table(1, count);
+    srand(seed);
+    double total = 0.0;
+    for (long long i = 0; i < count; i++) {
+        KeySegment key = i;
+        double value = (rand() % 8 == 0) ? 0.0 : rand() + 1.0;
+        table->addTuple(&key, value);
+        total += value;
+    }
+    for (long long i = 0; i < count; i++)
+        table->setValue(i, table->getValue(i) / total);
+    return table;
+}
+
+//-- distance from b to a, in units in the last place of b
+static double ulps(double a, double b) {
+    if (a == b)
+        return 0.0;
+    double unit = nextafter(fabs(b), INFINITY) - fabs(b);
+    return fabs(a - b) / unit;
+}
+
+static void checkLog() {
+    const long long n = 1 << 20;
+    double *x = new double[n];
+    double *y = new double[n];
+    srand(1);
+    for (long long i = 0; i < n; i++) {
+        double m = 1.0 + (double) rand() / RAND_MAX;
+        //-- half the values across the whole exponent range, half near 1 where log is small
+        x[i] = (i % 2 == 0) ? ldexp(m, rand() % 2040 - 1020) : m * (0.75 + 0.25 * (i % 3));
+    }
+    ocLogArray(x, y, n);
+    double worst = 0.0;
+    double worstX = 1.0;
+    for (long long i = 0; i < n; i++) {
+        double u = ulps(y[i], log(x[i]));
+        if (u > worst) {
+            worst = u;
+            worstX = x[i];
+        }
+    }
+    printf("log: %lld values, max error %.3f ulp (at %.17g) %s\n", n, worst, worstX,
+            worst <= 1.0 ? "ok" : "FAILED");
+    delete[] x;
+    delete[] y;
+}
+
+//-- run f repeatedly for at least half a second; returns seconds per call
+template <typename F>
+static double timeCalls(F f, double *result) {
+    *result = f(); // warm up
+    long count = 0;
+    clock_t t0 = clock();
+    clock_t t1;
+    do {
+        *result = f();
+        count++;
+        t1 = clock();
+    } while (t1 - t0 < CLOCKS_PER_SEC / 2);
+    return (double)(t1 - t0) / CLOCKS_PER_SEC / count;
+}
+
+int main(int argc, char* argv[]) {
+    long long count = argc > 1 ? atoll(argv[1]) : 1000000;
+    if (count <= 0) {
+        printf("usage: %s [tuples]\n", argv[0]);
+        return 1;
+    }
+    printf("Vector kernels: %s\n", ocVectorISA());
+    checkLog();
+
+    Table *p = makeTable(count, 2);
+    Table *q = makeTable(count, 3);
+    double hScalar, tScalar, h, t;
+    double hsScalar = timeCalls([&]() { return scalarEntropy(p); }, &hScalar);
+    double tsScalar = timeCalls([&]() { return scalarTransmission(p, q); }, &tScalar);
+    printf("%lld tuples\n", count);
+    printf("%-8s %12s %12s %12s %12s\n", "", "H (ms)", "rel diff", "T (ms)", "rel diff");
+    printf("%-8s %12.3f %12s %12.3f %12s\n", "scalar", hsScalar * 1000, "", tsScalar * 1000, "");
+
+    const char *isas[] = { "sse2", "avx2" };
+    double hVector[2], tVector[2];
+    bool ran[2] = { false, false };
+    for (int k = 0; k < 2; k++) {
+        if (!ocUseVectorISA(isas[k])) {
+            printf("%-8s (not supported)\n", isas[k]);
+            continue;
+        }
+        double hs = timeCalls([&]() { return ocEntropy(p); }, &h);
+        double ts = timeCalls([&]() { return ocTransmission(p, q); }, &t);
+        printf("%-8s %12.3f %12.3g %12.3f %12.3g   (%.1fx, %.1fx)\n", isas[k], hs * 1000,
+                fabs(h - hScalar) / fabs(hScalar), ts * 1000, fabs(t - tScalar) / fabs(tScalar),
+                hsScalar / hs, tsScalar / ts);
+        hVector[k] = h;
+        tVector[k] = t;
+        ran[k] = true;
+    }
+    if (ran[0] && ran[1]) {
+        bool same = hVector[0] == hVector[1] && tVector[0] == tVector[1];
+        printf("sse2 and avx2 sums %s\n", same ? "identical" : "DIFFER");
+    }
+    delete p;
+    delete q;
+    return 0;
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright © 1990 The Portland State University OCCAM Project Team
+ * [This program is licensed under the GPL version 3 or later.]
+ * Please see the file LICENSE in the source
+ * distribution of this software for license terms.
+ */
+
+/*
+ * keybench - times IPF fits with every key loop running its generic version, and then
+ * with the versions for the data's keysize (see Key::FixedKeys), and reports the speedup.
+ * Build with "make keybench".
+ *
+ *     keybench [-m model] datafile
+ *
+ * The model should have loops so IPF actually iterates; the default is AB:BC:AC. Fits use
+ * sparse tables (dense-threshold=0), since dense fits don't work on keys. The two versions
+ * take turns over ten rounds, and the best round of each is reported.
+ */
+
+#include "VBMManager.h"
+#include "Model.h"
+#include <stdio.h>
+#include <time.h>
+#include <vector>
+
+static const int ROUNDS = 10;
+
+//-- CPU seconds per fit, over at least a fifth of a second of fits
+static double timeFits(VBMManager *mgr, Model *model, int fixedKeyLimit) {
+    Key::fixedKeyLimit = fixedKeyLimit;
+    mgr->makeFitTableIPF(model); // warm up
+    long count = 0;
+    clock_t t0 = clock();
+    clock_t t1;
+    do {
+        mgr->makeFitTableIPF(model);
+        count++;
+        t1 = clock();
+    } while (t1 - t0 < CLOCKS_PER_SEC / 5);
+    return (double)(t1 - t0) / CLOCKS_PER_SEC / count;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc <= 1) {
+        printf("usage: %s [-m model] datafile\n", argv[0]);
+        return 1;
+    }
+    //-- sparse fits, unless the command line says otherwise
+    std::vector<char*> args(argv, argv + argc);
+    char sparse[] = "--dense-threshold=0";
+    args.insert(args.begin() + 1, sparse);
+    VBMManager *mgr = new VBMManager();
+    if (!mgr->initFromCommandLine((int) args.size(), &args[0]))
+        return 1;
+    const char *name;
+    if (!mgr->getOptionString("short-model", NULL, &name))
+        name = "AB:BC:AC";
+    Model *model = mgr->makeModel(name, true);
+    if (model == NULL) {
+        printf("ERROR: could not make model %s\n", name);
+        return 1;
+    }
+
+    //-- the versions take turns, and the best time of each is kept, so that changes in
+    //-- machine load affect both alike
+    int keysize = mgr->getKeySize();
+    int fixedLimit = Key::fixedKeyLimit;
+    double genericSecs = 0, fixedSecs = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+        double secs = timeFits(mgr, model, 0);
+        if (round == 0 || secs < genericSecs)
+            genericSecs = secs;
+        secs = timeFits(mgr, model, fixedLimit);
+        if (round == 0 || secs < fixedSecs)
+            fixedSecs = secs;
+    }
+    printf("Model %s, keysize %d, %lld tuples, %g IPF iterations per fit\n", name, keysize,
+            mgr->getInputData()->getTupleCount(), model->getAttribute(ATTRIBUTE_IPF_ITERATIONS));
+    printf("generic key loops:     %10.3f ms per fit\n", genericSecs * 1000);
+    if (Key::fixedKeySize(keysize) == 0) {
+        printf("no fixed-size key loops for keysize %d\n", keysize);
+    } else {
+        printf("keysize-%d key loops:   %10.3f ms per fit\n", keysize, fixedSecs * 1000);
+        printf("speedup: %.2fx\n", genericSecs / fixedSecs);
+    }
+    delete mgr;
+    return 0;
+}
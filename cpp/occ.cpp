@@ -33,7 +33,11 @@ int main(int argc, char* argv[]) {
 #else
     VBMManager *mgr = new VBMManager();
 #endif
-    mgr->initFromCommandLine(argc, argv);
+    if (!mgr->initFromCommandLine(argc, argv))
+        return 1;
+    double loadSecs = mgr->getLoadTime();
+    printf("Data load: %d lines in %f seconds (%.0f lines/second)\n", mgr->getDataLines(), loadSecs,
+            loadSecs > 0 ? mgr->getDataLines() / loadSecs : 0.0);
     Report *report = new Report(mgr);
     report->setSeparator(3);
     const char *action = "";
@@ -70,6 +74,10 @@ int main(int argc, char* argv[]) {
         if (!mgr->getOptionFloat("search-levels", NULL, &levels))
             levels = 3.0;
 
+        double warmStart;
+        if (!mgr->getOptionFloat("ipf-warm-start", NULL, &warmStart))
+            warmStart = 0;
+
         mgr->printBasicStatistics();
 #ifdef SB
         mgr->setSearch("sb-full-up");
@@ -110,7 +118,11 @@ int main(int argc, char* argv[]) {
                     for (model = models; *model; model++)
                         count++;
                     levelCount += count;
+                    mgr->makeProjections(models, count);
                     for (int i=0; i < count; i++) {
+                        //-- a provisional progenitor lets IPF warm-start from its fit
+                        if (warmStart > 0 && models[i]->getProgenitor() == NULL)
+                            models[i]->setProgenitor(keptModels[k]);
                         mgr->computeInformationStatistics(models[i]);
                     }
                     Report::sort(models, count, mgr->getSortAttr(), Direction::Descending);
@@ -152,11 +164,19 @@ int main(int argc, char* argv[]) {
                 report->addModel(nextModels[i]);
                 keptModels[i] = nextModels[i];
             }
+            //-- only the kept models are progenitors at the next level
+            for (; i < nextCount; i++)
+                mgr->dropWarmStart(nextModels[i]);
             delete[] nextModels;
+            mgr->reclaimCaches();
         }
         delete[] keptModels;
 
-        report->setAttributes("level$I, h, ddf, lr, alpha, information, aic, bic, incr_alpha, prog_id");
+        if (warmStart > 0)
+            report->setAttributes("level$I, h, ddf, lr, alpha, information, aic, bic, incr_alpha, prog_id, "
+                    "ipf_iterations, ipf_warm_start, ipf_iterations_saved");
+        else
+            report->setAttributes("level$I, h, ddf, lr, alpha, information, aic, bic, incr_alpha, prog_id");
         report->sort("information", Direction::Descending);
         report->print(stdout);
     }
@@ -0,0 +1,47 @@
+/*
+ * Copyright © 1990 The Portland State University OCCAM Project Team
+ * [This program is licensed under the GPL version 3 or later.]
+ * Please see the file LICENSE in the source
+ * distribution of this software for license terms.
+ */
+
+/*
+ * occconvert - converts a data file to a binary dataset, which occ and the Python
+ * bindings read in place of the data file without parsing it (see ocWriteDataset).
+ *
+ *     occconvert datafile dataset
+ */
+
+#include "Input.h"
+#include "Options.h"
+#include "VariableList.h"
+#include <stdio.h>
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        printf("usage: %s datafile dataset\n", argv[0]);
+        return 1;
+    }
+    FILE *fd = fopen(argv[1], "r");
+    if (fd == NULL) {
+        printf("ERROR: could not open %s\n", argv[1]);
+        return 1;
+    }
+    Options *options = new Options();
+    Table *indata = NULL, *testdata = NULL;
+    VariableList *vars = NULL;
+    int dataLines = ocReadFile(fd, options, &indata, &testdata, &vars);
+    if (dataLines <= 0) {
+        printf("ERROR: no data read from %s\n", argv[1]);
+        return 1;
+    }
+    bool ok = ocWriteDataset(argv[2], fd, dataLines, indata, testdata, vars);
+    fclose(fd);
+    if (!ok)
+        return 1;
+    printf("%s: %d variables, %lld tuples", argv[2], vars->getVarCount(), indata->getTupleCount());
+    if (testdata)
+        printf(", %lld test tuples", testdata->getTupleCount());
+    printf("\n");
+    return 0;
+}
@@ -187,6 +187,25 @@ DefinePyFunction(VBMManager, searchOneLevel) {
     return list;
 }
 
+// bool makeProjections(Model **models, int modelCount)
+DefinePyFunction(VBMManager, makeProjections) {
+    PyObject *Plist;
+    PyArg_ParseTuple(args, "O!", &PyList_Type, &Plist);
+    int count = PyList_Size(Plist);
+    Model **models = new Model*[count];
+    for (int i = 0; i < count; i++) {
+        PyObject *Pmodel = PyList_GetItem(Plist, i);
+        if (!PyObject_TypeCheck(Pmodel, &TModel) || ObjRef(Pmodel, Model) == NULL) {
+            delete[] models;
+            onError("makeProjections: list item is not a Model");
+        }
+        models[i] = ObjRef(Pmodel, Model);
+    }
+    bool success = ObjRef(self, VBMManager)->makeProjections(models, count);
+    delete[] models;
+    return Py_BuildValue("i", success ? 1 : 0);
+}
+
 // void setSearchType(const char *name)
 DefinePyFunction(VBMManager, setSearchType) {
     char *name;
@@ -581,6 +600,13 @@ DefinePyFunction(VBMManager, printOptions) {
     return Py_None;
 }
 
+// void reclaimCaches()
+DefinePyFunction(VBMManager, reclaimCaches) {
+    ObjRef(self, VBMManager)->reclaimCaches();
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
 // void deleteTablesFromCache()
 DefinePyFunction(VBMManager, deleteTablesFromCache) {
     ObjRef(self, VBMManager)->deleteTablesFromCache();
@@ -668,7 +694,8 @@ static struct PyMethodDef VBMManager_methods[] = { PyMethodDef(VBMManager, initF
         PyMethodDef(VBMManager, getDvName),
         PyMethodDef(VBMManager, makeAllChildRelations), PyMethodDef(VBMManager, makeChildModel),
         PyMethodDef(VBMManager, makeModel), PyMethodDef(VBMManager, setFilter),
-        PyMethodDef(VBMManager, searchOneLevel), PyMethodDef(VBMManager, setSearchType),
+        PyMethodDef(VBMManager, searchOneLevel), PyMethodDef(VBMManager, makeProjections),
+        PyMethodDef(VBMManager, setSearchType),
         PyMethodDef(VBMManager, getTopRefModel), PyMethodDef(VBMManager, getBottomRefModel),
         PyMethodDef(VBMManager, getRefModel), PyMethodDef(VBMManager, setRefModel),
         PyMethodDef(VBMManager, computeDF), PyMethodDef(VBMManager, computeH), PyMethodDef(VBMManager, computeT),
@@ -683,7 +710,8 @@ static struct PyMethodDef VBMManager_methods[] = { PyMethodDef(VBMManager, initF
         PyMethodDef(VBMManager, getOptionList), PyMethodDef(VBMManager, Report),
         PyMethodDef(VBMManager, makeFitTable), PyMethodDef(VBMManager, isDirected),
         PyMethodDef(VBMManager, printOptions), PyMethodDef(VBMManager, deleteTablesFromCache),
-        PyMethodDef(VBMManager, deleteModelFromCache), PyMethodDef(VBMManager, getSampleSz),
+        PyMethodDef(VBMManager, deleteModelFromCache), PyMethodDef(VBMManager, reclaimCaches),
+        PyMethodDef(VBMManager, getSampleSz),
         PyMethodDef(VBMManager, printBasicStatistics), PyMethodDef(VBMManager, computePercentCorrect),
         PyMethodDef(VBMManager, printSizes), PyMethodDef(VBMManager, getMemUsage),
         PyMethodDef(VBMManager, hasTestData), PyMethodDef(VBMManager, dumpRelations),
@@ -803,6 +831,25 @@ DefinePyFunction(SBMManager, searchOneLevel) {
     return list;
 }
 
+// bool makeProjections(Model **models, int modelCount)
+DefinePyFunction(SBMManager, makeProjections) {
+    PyObject *Plist;
+    PyArg_ParseTuple(args, "O!", &PyList_Type, &Plist);
+    int count = PyList_Size(Plist);
+    Model **models = new Model*[count];
+    for (int i = 0; i < count; i++) {
+        PyObject *Pmodel = PyList_GetItem(Plist, i);
+        if (!PyObject_TypeCheck(Pmodel, &TModel) || ObjRef(Pmodel, Model) == NULL) {
+            delete[] models;
+            onError("makeProjections: list item is not a Model");
+        }
+        models[i] = ObjRef(Pmodel, Model);
+    }
+    bool success = ObjRef(self, SBMManager)->makeProjections(models, count);
+    delete[] models;
+    return Py_BuildValue("i", success ? 1 : 0);
+}
+
 // void setSearchType(const char *name)
 DefinePyFunction(SBMManager, setSearchType) {
     char *name;
@@ -1151,6 +1198,13 @@ DefinePyFunction(SBMManager, deleteModelFromCache) {
     return Py_BuildValue("i", success ? 1 : 0);
 }
 
+// void reclaimCaches()
+DefinePyFunction(SBMManager, reclaimCaches) {
+    ObjRef(self, SBMManager)->reclaimCaches();
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
 // void deleteTablesFromCache()
 DefinePyFunction(SBMManager, deleteTablesFromCache) {
     ObjRef(self, SBMManager)->deleteTablesFromCache();
@@ -1207,7 +1261,8 @@ DefinePyFunction(SBMManager, hasTestData) {
 }
 
 static struct PyMethodDef SBMManager_methods[] = { PyMethodDef(SBMManager, initFromCommandLine),
-        PyMethodDef(SBMManager, searchOneLevel), PyMethodDef(SBMManager, makeSbModel),
+        PyMethodDef(SBMManager, searchOneLevel), PyMethodDef(SBMManager, makeProjections),
+        PyMethodDef(SBMManager, makeSbModel),
         PyMethodDef(SBMManager, setFilter), PyMethodDef(SBMManager, setSearchType),
         PyMethodDef(SBMManager, getTopRefModel), PyMethodDef(SBMManager, getBottomRefModel),
         PyMethodDef(SBMManager, getRefModel), PyMethodDef(SBMManager, setRefModel),
@@ -1221,6 +1276,7 @@ static struct PyMethodDef SBMManager_methods[] = { PyMethodDef(SBMManager, initF
         PyMethodDef(SBMManager, Report), PyMethodDef(SBMManager, makeFitTable),
         PyMethodDef(SBMManager, isDirected), PyMethodDef(SBMManager, printOptions),
         PyMethodDef(SBMManager, deleteModelFromCache), PyMethodDef(SBMManager, deleteTablesFromCache),
+        PyMethodDef(SBMManager, reclaimCaches),
         PyMethodDef(SBMManager, computePercentCorrect), PyMethodDef(SBMManager, getSampleSz), PyMethodDef(SBMManager, getMemUsage),
         PyMethodDef(SBMManager, printBasicStatistics), PyMethodDef(SBMManager, hasTestData), { NULL, NULL, 0 } };
 
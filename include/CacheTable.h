@@ -0,0 +1,270 @@
+/*
+ * Copyright © 1990 The Portland State University OCCAM Project Team
+ * [This program is licensed under the GPL version 3 or later.]
+ * Please see the file LICENSE in the source
+ * distribution of this software for license terms.
+ */
+
+#ifndef ___CacheTable
+#define ___CacheTable
+
+#include <atomic>
+#include <mutex>
+#include <string.h>
+#include <vector>
+
+/**
+ * CacheTable - the hash table under RelCache and ModelCache: cached objects (relations or
+ * models) keyed by their print names, safe to use from several threads at once.
+ *
+ * The table is split into shards by hash, each an open-addressing table with its own lock,
+ * which doubles when it is half full. Lookups don't lock: they probe the shard's current
+ * slot array, and only on a miss (which may just mean the slots are changing) look again
+ * with the lock held. findOrAdd is the atomic insert-or-get.
+ *
+ * Slots point to entries which hold each object's hash and a copy of its name, so probing
+ * never touches the cached objects themselves, and an object can be deleted as soon as it
+ * has been removed, while other threads probe past where it was. Entries of removed
+ * objects, and slot arrays replaced by growth, may still be read by a lookup, so they are
+ * kept until reclaim is called at a point where no other thread is using the table (such
+ * as the end of a search level), or the table is deleted. The table doesn't own the
+ * objects; deleting one is only safe once no other thread holds it.
+ */
+template <typename T>
+class CacheTable {
+    public:
+        CacheTable() {
+            for (int s = 0; s < SHARDS; s++) {
+                shards[s].slots.store(newSlots(16), std::memory_order_relaxed);
+                shards[s].count = 0;
+            }
+        }
+
+        ~CacheTable() {
+            for (int s = 0; s < SHARDS; s++) {
+                Slots *slots = shards[s].slots.load(std::memory_order_relaxed);
+                for (long long i = 0; i < slots->capacity; i++)
+                    deleteEntry(slots->slot[i].load(std::memory_order_relaxed));
+                deleteSlots(slots);
+                for (size_t i = 0; i < shards[s].retired.size(); i++)
+                    deleteSlots(shards[s].retired[i]);
+                for (size_t i = 0; i < shards[s].removed.size(); i++)
+                    deleteEntry(shards[s].removed[i]);
+            }
+        }
+
+        //-- find an object by name; NULL if there is none
+        T *find(const char *name) {
+            unsigned long long hash = hashName(name);
+            Shard &shard = shards[hash & (SHARDS - 1)];
+            Entry *entry = probe(shard.slots.load(std::memory_order_acquire), hash, name);
+            if (entry == NULL) {
+                std::lock_guard<std::mutex> guard(shard.lock);
+                entry = probe(shard.slots.load(std::memory_order_relaxed), hash, name);
+            }
+            return entry ? entry->item : NULL;
+        }
+
+        //-- add item, unless an object with the same name is already in the table. Returns
+        //-- whichever is in the table afterwards, so a result other than item means item
+        //-- wasn't added.
+        T *findOrAdd(T *item) {
+            const char *name = item->getPrintName();
+            unsigned long long hash = hashName(name);
+            Shard &shard = shards[hash & (SHARDS - 1)];
+            std::lock_guard<std::mutex> guard(shard.lock);
+            Slots *slots = shard.slots.load(std::memory_order_relaxed);
+            Entry *found = probe(slots, hash, name);
+            if (found)
+                return found->item;
+            if (2 * (shard.count + 1) > slots->capacity)
+                slots = grow(shard);
+            place(slots, newEntry(item, hash, name));
+            shard.count++;
+            return item;
+        }
+
+        //-- remove item from the table; false if it isn't there
+        bool remove(T *item) {
+            unsigned long long hash = hashName(item->getPrintName());
+            Shard &shard = shards[hash & (SHARDS - 1)];
+            std::lock_guard<std::mutex> guard(shard.lock);
+            Slots *slots = shard.slots.load(std::memory_order_relaxed);
+            long long mask = slots->capacity - 1;
+            long long i = home(hash, mask);
+            Entry *at;
+            while ((at = slots->slot[i].load(std::memory_order_relaxed)) == NULL || at->item != item) {
+                if (at == NULL)
+                    return false;
+                i = (i + 1) & mask;
+            }
+            shard.removed.push_back(at);
+            //-- close the gap, moving back any later entries of the probe run which belong
+            //-- at or before it (there are no tombstones)
+            slots->slot[i].store(NULL, std::memory_order_release);
+            for (long long j = (i + 1) & mask; (at = slots->slot[j].load(std::memory_order_relaxed)) != NULL;
+                    j = (j + 1) & mask) {
+                long long k = home(at->hash, mask);
+                bool movable = (i <= j) ? (k <= i || k > j) : (k <= i && k > j);
+                if (movable) {
+                    slots->slot[i].store(at, std::memory_order_release);
+                    slots->slot[j].store(NULL, std::memory_order_release);
+                    i = j;
+                }
+            }
+            shard.count--;
+            return true;
+        }
+
+        //-- call visit(item) for every object in the table, locking one shard at a time.
+        //-- visit may delete the object, but must not use the table.
+        template <typename F>
+        void forEach(F visit) {
+            for (int s = 0; s < SHARDS; s++) {
+                std::lock_guard<std::mutex> guard(shards[s].lock);
+                Slots *slots = shards[s].slots.load(std::memory_order_relaxed);
+                for (long long i = 0; i < slots->capacity; i++) {
+                    Entry *entry = slots->slot[i].load(std::memory_order_relaxed);
+                    if (entry)
+                        visit(entry->item);
+                }
+            }
+        }
+
+        //-- free the entries of removed objects, and replaced slot arrays. No other thread
+        //-- may be using the table.
+        void reclaim() {
+            for (int s = 0; s < SHARDS; s++) {
+                std::lock_guard<std::mutex> guard(shards[s].lock);
+                for (size_t i = 0; i < shards[s].retired.size(); i++)
+                    deleteSlots(shards[s].retired[i]);
+                shards[s].retired.clear();
+                for (size_t i = 0; i < shards[s].removed.size(); i++)
+                    deleteEntry(shards[s].removed[i]);
+                shards[s].removed.clear();
+            }
+        }
+
+        //-- memory used by the table itself (not the objects)
+        long size() {
+            long size = sizeof(CacheTable);
+            for (int s = 0; s < SHARDS; s++) {
+                std::lock_guard<std::mutex> guard(shards[s].lock);
+                Slots *slots = shards[s].slots.load(std::memory_order_relaxed);
+                size += slots->capacity * sizeof(std::atomic<Entry*>);
+                for (long long i = 0; i < slots->capacity; i++) {
+                    Entry *entry = slots->slot[i].load(std::memory_order_relaxed);
+                    if (entry)
+                        size += sizeof(Entry) + strlen(entry->name) + 1;
+                }
+                for (size_t i = 0; i < shards[s].retired.size(); i++)
+                    size += shards[s].retired[i]->capacity * sizeof(std::atomic<Entry*>);
+                for (size_t i = 0; i < shards[s].removed.size(); i++)
+                    size += sizeof(Entry) + strlen(shards[s].removed[i]->name) + 1;
+            }
+            return size;
+        }
+
+    private:
+        static const int SHARD_BITS = 6;
+        static const int SHARDS = 1 << SHARD_BITS;
+
+        //-- never changed once published
+        struct Entry {
+            unsigned long long hash;
+            T *item;
+            char *name;
+        };
+
+        struct Slots {
+            long long capacity; // a power of 2
+            std::atomic<Entry*> *slot;
+        };
+
+        struct Shard {
+            std::mutex lock; // held by writers
+            std::atomic<Slots*> slots;
+            long long count; // objects in the shard
+            std::vector<Slots*> retired; // replaced slot arrays
+            std::vector<Entry*> removed; // entries of removed objects
+        };
+
+        static Entry *newEntry(T *item, unsigned long long hash, const char *name) {
+            Entry *entry = new Entry;
+            entry->hash = hash;
+            entry->item = item;
+            entry->name = new char[strlen(name) + 1];
+            strcpy(entry->name, name);
+            return entry;
+        }
+
+        static void deleteEntry(Entry *entry) {
+            if (entry) {
+                delete[] entry->name;
+                delete entry;
+            }
+        }
+
+        static Slots *newSlots(long long capacity) {
+            Slots *slots = new Slots;
+            slots->capacity = capacity;
+            slots->slot = new std::atomic<Entry*>[capacity];
+            for (long long i = 0; i < capacity; i++)
+                slots->slot[i].store(NULL, std::memory_order_relaxed);
+            return slots;
+        }
+
+        static void deleteSlots(Slots *slots) {
+            delete[] slots->slot;
+            delete slots;
+        }
+
+        //-- FNV-1a; the low bits pick the shard, and the rest the slot
+        static unsigned long long hashName(const char *name) {
+            unsigned long long h = 14695981039346656037ULL;
+            for (const char *cp = name; *cp; cp++) {
+                h ^= (unsigned char) *cp;
+                h *= 1099511628211ULL;
+            }
+            return h;
+        }
+
+        static long long home(unsigned long long hash, long long mask) {
+            return (long long) (hash >> SHARD_BITS) & mask;
+        }
+
+        static Entry *probe(Slots *slots, unsigned long long hash, const char *name) {
+            long long mask = slots->capacity - 1;
+            for (long long i = home(hash, mask);; i = (i + 1) & mask) {
+                Entry *entry = slots->slot[i].load(std::memory_order_acquire);
+                if (entry == NULL || (entry->hash == hash && strcmp(entry->name, name) == 0))
+                    return entry;
+            }
+        }
+
+        static void place(Slots *slots, Entry *entry) {
+            long long mask = slots->capacity - 1;
+            long long i = home(entry->hash, mask);
+            while (slots->slot[i].load(std::memory_order_relaxed) != NULL)
+                i = (i + 1) & mask;
+            slots->slot[i].store(entry, std::memory_order_release);
+        }
+
+        //-- double the shard's slots; the new array is filled before it is published
+        static Slots *grow(Shard &shard) {
+            Slots *old = shard.slots.load(std::memory_order_relaxed);
+            Slots *slots = newSlots(2 * old->capacity);
+            for (long long i = 0; i < old->capacity; i++) {
+                Entry *entry = old->slot[i].load(std::memory_order_relaxed);
+                if (entry)
+                    place(slots, entry);
+            }
+            shard.slots.store(slots, std::memory_order_release);
+            shard.retired.push_back(old);
+            return slots;
+        }
+
+        Shard shards[SHARDS];
+};
+
+#endif
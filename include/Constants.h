@@ -8,10 +8,10 @@
 #ifndef ___Constants
 #define ___Constants
 
-const int DONT_CARE = 0xffffffff; // all bits on
-const int KEY_SEGMENT_BITS = 32; // number of usable bits in a key segment
-//const int DONT_CARE = ULONG_MAX;	// all bits on
-//const int KEY_SEGMENT_BITS = sizeof(KeySegment) * 8;	// number of usable bits in a key segment
+#include "Types.h"
+
+const int DONT_CARE = 0xffffffff; // all bits on; sign-extends to a full KeySegment of 1's
+const int KEY_SEGMENT_BITS = sizeof(KeySegment) * 8; // number of usable bits in a key segment
 
 const int MAXNAMELEN = 32;
 const int MAXABBREVLEN = 8;
@@ -21,6 +21,7 @@ const int ALL = 1;
 const int REST_ALL = -1;
 const int KEEP = 1;
 const int DISCARD = -1;
+const int REBIN_KEEP = -2; // a value rebinning leaves as it is
 
 const double PRINT_MIN = 1e-8;
 const double PROB_MIN = 1e-36;
@@ -48,6 +49,9 @@ const double PROB_MIN = 1e-36;
 #define ATTRIBUTE_T_FROM_H "t_h"
 #define ATTRIBUTE_IPF_ITERATIONS "ipf_iterations"
 #define ATTRIBUTE_IPF_ERROR "ipf_error"
+#define ATTRIBUTE_IPF_RATE "ipf_iterations_per_sec"
+#define ATTRIBUTE_IPF_WARM_START "ipf_warm_start"
+#define ATTRIBUTE_IPF_SAVED "ipf_iterations_saved"
 #define ATTRIBUTE_PROCESSED "processed"
 #define ATTRIBUTE_IND_H "h_ind_vars"
 #define ATTRIBUTE_DEP_H "h_dep_vars"
@@ -0,0 +1,81 @@
+/*
+ * Copyright © 1990 The Portland State University OCCAM Project Team
+ * [This program is licensed under the GPL version 3 or later.]
+ * Please see the file LICENSE in the source
+ * distribution of this software for license terms.
+ */
+
+#ifndef ___DenseTable
+#define ___DenseTable
+
+#include "Types.h"
+
+class Relation;
+class Table;
+class VariableList;
+
+/**
+ * DenseTable - a table over the complete state space of a variable list, stored as a
+ * flat array of values indexed by mixed-radix state number. The last variable varies
+ * fastest, which matches the packing of variables into keys, so walking the states in
+ * order visits keys in sorted order.
+ *
+ * A DenseTable can also cover just the variables of a relation; its keys then have the
+ * other variables as DONT_CARE, like the keys of the relation's own table.
+ *
+ * When the state space is small, this is much cheaper than a sparse Table: lookups are
+ * arithmetic rather than binary searches, and a relation's marginal is a single pass
+ * that sums each state into its relation cell (see makeCellMap).
+ */
+class DenseTable {
+    public:
+        DenseTable(VariableList *vars);
+        DenseTable(VariableList *vars, Relation *rel);
+        ~DenseTable();
+
+        //-- true if the full state space of vars has no more than maxStates states
+        static bool fits(VariableList *vars, double maxStates);
+
+        long long getStateCount() {
+            return stateCount;
+        }
+        double *getValues() {
+            return values;
+        }
+        void clear();
+
+        //-- mixed-radix state number of a key with every covered variable set, and the reverse
+        long long stateOf(KeySegment *key);
+        void keyOf(long long state, KeySegment *key);
+
+        //-- add the tuples of a sparse table into the dense array
+        void addTable(Table *table);
+
+        //-- append the states with values above minValue to a (reset) sparse table; the
+        //-- result is already in sorted order
+        void toTable(Table *table, double minValue = 0.0);
+
+        //-- build a map giving, for each state, its cell within the relation's own state
+        //-- space; NULL unless the relation's variables are all covered by the table. cellCount
+        //-- receives the number of cells in the relation. The caller owns the returned array.
+        unsigned int *makeCellMap(Relation *rel, long long *cellCount);
+
+        //-- cell number of a relation tuple key, consistent with makeCellMap
+        long long cellOf(Relation *rel, KeySegment *key);
+
+    private:
+        void init(VariableList *vars, int *indices, int count);
+        int positionOf(int var);
+
+        VariableList *varList;
+        bool full; // covers every variable in varList
+        int varCount;
+        int *varIndices; // per position, the index of the variable in varList
+        int keysize;
+        long long stateCount;
+        long long *strides; // per position, the state-number weight of one unit of its value
+        int *cards; // per position cardinality
+        double *values;
+};
+
+#endif
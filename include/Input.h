@@ -21,5 +21,20 @@
 int ocReadFile(FILE *fd, class Options *options,
 	Table **indata, Table **testdata, VariableList **vars);
 
+/**
+ * ocOpenInput - open a data file for ocReadFile. "-" is the standard input, and input
+ * compressed with gzip or zstd is decompressed as it is read. Returns NULL if the file
+ * can't be opened.
+ */
+FILE *ocOpenInput(const char *fname);
+
+/**
+ * ocWriteDataset - write what ocReadFile read from source (a data file) as a binary
+ * dataset, which ocReadFile can then read in place of the data file, without parsing.
+ * Returns false, after printing an error, if the file can't be written.
+ */
+bool ocWriteDataset(const char *path, FILE *source, int dataLines, Table *indata, Table *testdata,
+	VariableList *vars);
+
 #endif
 
@@ -46,6 +46,73 @@ namespace Key {
     void keyToUserString(KeySegment *key, VariableList *var, char *str, const char *delim, bool showKey=true);
     void getSiblings(KeySegment *key, VariableList *vars, Table *table, long *i_sibs, int DV_ind, int *no_sib);
     void dumpKey(KeySegment *key, int keysize);
+
+    /* Hash of a whole key, for the open-addressing indexes over tables and constraints. */
+    inline unsigned long long hashKey(const KeySegment *key, int keysize) {
+        unsigned long long h = 0x9e3779b97f4a7c15ULL;
+        for (int i = 0; i < keysize; i++) {
+            h ^= (unsigned long long) key[i];
+            h *= 0xff51afd7ed558ccdULL;
+            h ^= h >> 32;
+        }
+        //-- values are packed from the top of each segment, so fold the high bits down
+        //-- into the low ones, which pick the slot
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    /* Fixed-size key loops - the hot per-tuple key operations, written for keys of N
+     * segments so the compiler unrolls them and inlines them into their callers, with
+     * N = 0 for the generic loop over keysize (which the fixed versions ignore). Nearly
+     * every data set has keys of 1 to 4 segments. A hot loop is a template on N, and picks
+     * its instance once per call, not once per key, with KEY_SWITCH (below). */
+    template <int N> struct FixedKeys {
+        static int compare(const KeySegment *key1, const KeySegment *key2, int keysize) {
+            for (int i = 0; i < (N ? N : keysize); i++) {
+                if (key1[i] != key2[i])
+                    return key1[i] < key2[i] ? -1 : 1;
+            }
+            return 0;
+        }
+        static bool equal(const KeySegment *key1, const KeySegment *key2, int keysize) {
+            KeySegment diff = 0;
+            for (int i = 0; i < (N ? N : keysize); i++)
+                diff |= key1[i] ^ key2[i];
+            return diff == 0;
+        }
+        static void applyMask(KeySegment *dest, const KeySegment *key, const KeySegment *mask, int keysize) {
+            for (int i = 0; i < (N ? N : keysize); i++)
+                dest[i] = key[i] | mask[i];
+        }
+    };
+
+    /* The largest keysize with a fixed-size instance; 0 sends every key loop to the
+     * generic one (keybench does this to measure the difference). */
+    extern int fixedKeyLimit;
+
+    /* N for a key loop over keys of keysize segments */
+    inline int fixedKeySize(int keysize) {
+        return keysize <= fixedKeyLimit ? keysize : 0;
+    }
+
+    /* Set dest to key with the masked-off variables set to DONT_CARE, for callers whose
+     * loops are dominated by other work. */
+    inline void applyMask(KeySegment *dest, const KeySegment *key, const KeySegment *mask, int keysize) {
+        FixedKeys<0>::applyMask(dest, key, mask, keysize);
+    }
 };
 
+/* KEY_SWITCH - return fn<N> args, for N = Key::fixedKeySize(keysize), where fn is a
+ * function template whose key loops use Key::FixedKeys<N>. */
+#define KEY_SWITCH(keysize, fn, args) \
+    switch (Key::fixedKeySize(keysize)) { \
+        case 1: return fn<1> args; \
+        case 2: return fn<2> args; \
+        case 3: return fn<3> args; \
+        case 4: return fn<4> args; \
+        default: return fn<0> args; \
+    }
+
 #endif 
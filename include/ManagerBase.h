@@ -11,7 +11,10 @@
 #include "Model.h"
 #include "Options.h"
 #include "VarIntersect.h"
+#include <list>
 #include <map>
+#include <string>
+#include <vector>
 
 /**
  * ocIntersectProcessor - this is a base class for processing classes
@@ -56,9 +59,10 @@ typedef map<Relation*, long long> FitIntersectMap;
 class ManagerBase {
     public:
         // method to use for computing H. Auto means use IPF if there are loops and
-        // algebraic method otherwise.
+        // algebraic method otherwise. Junction tree fits models with loops exactly where
+        // the model decomposes, and uses IPF only within the parts that don't.
         enum HMethod {
-            AUTO, IPF, ALGEBRAIC
+            AUTO, IPF, ALGEBRAIC, JUNCTION_TREE
         };
 
 
@@ -106,12 +110,25 @@ class ManagerBase {
         // as many times as needed.
         virtual bool makeProjections(Model *model);
 
+        // make projections for all relations of a set of models, such as the candidates of
+        // a search level. Each distinct relation is projected once; with projection-threads
+        // above 1, independent relations are projected concurrently.
+        virtual bool makeProjections(Model **models, int modelCount);
+
         // delete projection tables from all relations in cache
         virtual void deleteTablesFromCache();
 
+        // release the least recently used relation tables while they take more memory than
+        // the table-budget option allows, keeping those used after the stamp since
+        void trimTableCache(unsigned long long since);
+
         // delete a model from the model cache
         virtual bool deleteModelFromCache(Model *model);
 
+        // free what the caches still keep of deleted models. Call this only where no other
+        // thread is using the caches, such as between search levels.
+        void reclaimCaches();
+
 
         // Make a fit table. This function uses the IPF algorithm. The fit table is
         // linked to the model.  If the model already has a fit table, the function
@@ -120,6 +137,10 @@ class ManagerBase {
         virtual bool makeFitTable(Model *model);
         virtual bool makeFitTableIPF(Model *model);
         virtual bool makeFitTableAlgebraic(Model *model);
+        // Fit a model with loops by triangulating it (see ManagerFitJunctionTree.cpp).
+        // Falls back to makeFitTableIPF for state-based models, or when a part of the model
+        // which needs IPF is too large for a dense table (warning once, see junctionTreeFallback).
+        virtual bool makeFitTableJunctionTree(Model *model);
 
         // Expand a single tuple into all values of all missing variables, recursively
         void expandTuple(double tupleValue, KeySegment *key, int *missingVars, int missingCount, Table *outTable,
@@ -128,6 +149,32 @@ class ManagerBase {
         void makeOrthoExpansion(Relation *rel, Table *table);
         void makeSbExpansion(Relation *rel, Table *table);
 
+        // True if the full state space is small enough (see the dense-threshold option)
+        // for fitting to use a DenseTable rather than sparse tables.
+        bool useDenseTables();
+
+        // True if models with loops are fit by makeFitTableJunctionTree rather than
+        // makeFitTableIPF (the fit-method option).
+        bool useJunctionTree();
+
+        // Number of threads for IPF passes (the ipf-threads option; 0 means all cores)
+        int getIPFThreads();
+
+        // Number of threads for projecting relations (the projection-threads option)
+        int getProjectionThreads();
+
+        // True if IPF passes are extrapolated (the ipf-accelerate option)
+        bool useIPFAcceleration();
+
+        // Fit tables kept for warm-starting IPF during a search (see the ipf-warm-start option).
+        // findWarmStart returns the fit of the model's progenitor, if the model contains it,
+        // and sets source to the progenitor; saveWarmStart caches a copy of fitTable1 as the
+        // model's fit; dropWarmStart forgets the model's fit, once the search has dropped it.
+        Table *findWarmStart(Model *model, Model *&source);
+        void saveWarmStart(Model *model);
+        void dropWarmStart(Model *model);
+        void clearFitCache();
+
         // Process relations and intersections, as need for DF and H computation
         void doIntersectionProcessing(Model *model, ocIntersectProcessor *proc);
 
@@ -194,6 +241,13 @@ class ManagerBase {
         double getSampleSz() {
             return sampleSize;
         }
+        int getDataLines() {
+            return dataLines;
+        }
+        // seconds of processor time spent reading (and sorting) the data files
+        double getLoadTime() {
+            return loadTime;
+        }
         double getTestSampleSize() {
             return testSampleSize;
         }
@@ -273,6 +327,34 @@ class ManagerBase {
         Model* projectedModel(Relation* projectTo, Model* model);
 
     protected:
+        // fit the model by makeFitTableIPF, as the junction tree fit won't. The first time,
+        // print the reason, so the fit-method option isn't overridden silently.
+        bool junctionTreeFallback(Model *model, const char *reason);
+
+        // the table a new projection for rel is read from: inputData, or the smallest
+        // cached superset table. Also counts the projection for printSizes.
+        Table *projectionSource(Relation *rel);
+
+        // the on-disk cache of relation tables for the current input data (see the
+        // projection-cache option), or NULL if there is none
+        class ProjectionCache *getDiskCache();
+
+        // search levels of fits to keep for warm starts (the ipf-warm-start option), or 0
+        // while inputData is swapped for something else
+        int warmStartLevels();
+
+        // IPF over dense state-space arrays; called by makeFitTableIPF when useDenseTables(),
+        // and false if a relation can't be mapped onto them
+        bool denseIPF(Relation **relList, int relCount, int startRel, Table *warmStart, double delta2,
+                double maxiter, int &iter, double &error, std::vector<double> *trace);
+        // IPF over the fixed support of fitTable1, using precomputed tuple-to-marginal maps
+        void indexedIPF(Relation **relList, int relCount, double delta2, double maxiter, int &iter,
+                double &error, std::vector<double> *trace);
+        // IPF passes over a flat array of fit values, given each value's cell in each relation
+        static void ipfPasses(double *values, long long count, int relCount, unsigned int **cellMaps,
+                double **relValues, long long *cellCounts, double delta2, double maxiter, int threads,
+                int &iter, double &error, bool accelerate = false, std::vector<double> *trace = NULL);
+
         Model *topRef;
         Model *bottomRef;
         Model *refModel;
@@ -291,6 +373,7 @@ class ManagerBase {
         Table *fitTable2;
         Table *projTable;
         int dataLines;
+        double loadTime;
         int *DVOrder;
         int useInverseNotation;
         VarIntersect *intersectArray;
@@ -300,6 +383,23 @@ class ManagerBase {
         double negativeConstant;
         bool valuesAreFunctions;
         Direction searchDirection;
+        //-- fits for warm starts, keyed by model print name, so deleted models don't dangle,
+        //-- and kept for ipf-warm-start search levels
+        struct CachedFit {
+            std::string name;
+            int level;
+            Table *table;
+        };
+        std::list<CachedFit> fitCache;
+        bool warmStartPaused;
+        Table *projectionData; // the data the relation tables in relCache are projected from
+        long long projectionCount; // relation tables made by makeProjection(Relation*)
+        long long projectionSupersetHits; // of those, how many were made from a cached superset
+        long long projectionSourceTuples; // total size of the tables they were made from
+        long long tablesReleased; // relation tables dropped to stay within the table-budget option
+        unsigned long long batchSince; // use stamp before the last batch of projections
+        class ProjectionCache *diskCache;
+        bool junctionTreeWarned; // junctionTreeFallback has printed its warning
 
 
 };
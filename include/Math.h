@@ -31,7 +31,6 @@ double ocEntropy(Table *p);
  */
 double ocTransmission(Table *p, Table *q);
 
-double ocInfoDist(Table* p1, Table* q1, Table* q2);
 double ocAbsDist(Table* p, Table* q);
 double ocTransmissionFlat(Table* p, Table* q);
 double ocEucDist(Table* p, Table* q);
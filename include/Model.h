@@ -47,14 +47,6 @@ class Model {
         // get a printable name for the relation, using the variable abbreviations
         const char *getPrintName(int useInverse = 0);
 
-        // set, get hash chain linkages
-        Model *getHashNext() {
-            return hashNext;
-        }
-        void setHashNext(Model *next) {
-            hashNext = next;
-        }
-
         // Checks if this model contains the specified relation.  That is, checks if any of
         // the model's relations *contain* this relation, not if any of them *are* this relation.
         bool containsRelation(Relation *relation, ModelCache *cache=NULL);
@@ -105,7 +97,6 @@ class Model {
         int maxRelationCount;
         class Table *fitTable;
         class AttributeList *attributeList;
-        Model *hashNext;
         char *printName;
         char *inverseName;
         int **structMatrix;
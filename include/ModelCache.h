@@ -14,9 +14,11 @@
  * the cache matches on the printName for the model, which uniquely identifies the
  * set of relations.
  * There must be a separate model cache for each different problem instance.
+ * The cache may be used from several threads at once (see CacheTable).
  *
  */
-#define MODELCACHE_HASHSIZE 1001
+#include "CacheTable.h"
+
 class ModelCache {
     public:
 	//-- construct an empty model cache
@@ -31,7 +33,12 @@ class ModelCache {
 	//-- exists, an error is returned.
 	bool addModel(class Model *model);
 
-	//-- deleteModel - deletes a model from the cache.
+	//-- findOrAddModel - put a new model in the cache, unless a matching one is already
+	//-- there, as one step. Returns the cached model; if that isn't model, model wasn't
+	//-- added.
+	class Model *findOrAddModel(class Model *model);
+
+	//-- deleteModel - deletes a model from the cache. No other thread may be using it.
 	//-- returns true if successful, false if not found.
 	bool deleteModel(class Model *model);
 
@@ -39,10 +46,14 @@ class ModelCache {
 	//-- model doesn't exist.
 	class Model *findModel(const char *name);
 
+	//-- reclaim - free what the cache keeps of deleted models (see CacheTable::reclaim).
+	//-- No other thread may be using the cache.
+	void reclaim();
+
 	void dump();
 
     private:
-	class Model **hash;
+	CacheTable<class Model> models;
 };
 
 #endif
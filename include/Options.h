@@ -38,6 +38,8 @@ class Options {
 
 	//-- line reader function; for use by other input services
 	static bool getLine(FILE *fd, char *line, int *lineno);
+	//-- the same, reading from the buffer at *pos up to end, and advancing *pos
+	static bool getLine(const char **pos, const char *end, char *line, int *lineno);
 
 	//-- set individual options
 	bool setOptionString(ocOptionDef *def, const char *value);
@@ -0,0 +1,58 @@
+/*
+ * Copyright © 1990 The Portland State University OCCAM Project Team
+ * [This program is licensed under the GPL version 3 or later.]
+ * Please see the file LICENSE in the source
+ * distribution of this software for license terms.
+ */
+
+#ifndef ___Parallel
+#define ___Parallel
+
+#include <functional>
+#include <thread>
+
+/**
+ * ocThreadCount - resolve a requested thread count; 0 (or less) means one thread per core.
+ */
+inline int ocThreadCount(int requested) {
+    if (requested > 0)
+        return requested;
+    int cores = (int) std::thread::hardware_concurrency();
+    return cores > 0 ? cores : 1;
+}
+
+/**
+ * ocRunParallel - call task(t) for t = 0 .. tasks-1 and return once all have finished.
+ * Task 0 runs on the calling thread, and the others on the threads of a pool which is
+ * started as threads are first needed and then kept, so a call costs no thread startup,
+ * and per-thread (thread_local) scratch space lasts from one call to the next. If the
+ * pool is already busy (a nested call, or another thread's), the tasks run in order on
+ * the calling thread instead.
+ */
+void ocRunParallel(int tasks, const std::function<void(int)> &task);
+
+/**
+ * parallelFor - split [0, count) into one contiguous block per thread and call
+ * body(begin, end, thread) for each block, where thread is 0 .. threads-1 in block
+ * order. The calling thread takes block 0, and the pool of ocRunParallel the rest.
+ * Block boundaries depend only on count and threads, so callers can combine per-thread
+ * results in a fixed order.
+ */
+template <typename F>
+void parallelFor(int threads, long long count, F body) {
+    if (threads > count)
+        threads = (int) count;
+    if (threads <= 1) {
+        body(0LL, count, 0);
+        return;
+    }
+    long long chunk = (count + threads - 1) / threads;
+    int blocks = (int) ((count + chunk - 1) / chunk);
+    ocRunParallel(blocks, [&](int t) {
+        long long begin = t * chunk;
+        long long end = begin + chunk < count ? begin + chunk : count;
+        body(begin, end, t);
+    });
+}
+
+#endif
@@ -0,0 +1,54 @@
+/*
+ * Copyright © 1990 The Portland State University OCCAM Project Team
+ * [This program is licensed under the GPL version 3 or later.]
+ * Please see the file LICENSE in the source
+ * distribution of this software for license terms.
+ */
+
+#ifndef ___ProjectionCache
+#define ___ProjectionCache
+
+#include "Types.h"
+
+class Relation;
+class Table;
+
+/**
+ * ProjectionCache - relation tables kept on disk between runs, so repeated searches over
+ * the same data don't project every relation again. A table is filed under a fingerprint
+ * of the input data's tuples together with the relation's mask; since these fully
+ * determine the projection, a file found under the same name can simply be reused.
+ *
+ * Each file holds a small header (magic, keysize, fingerprint, tuple count, mask) and
+ * then the tuples in Table's own in-memory layout, so a cached table is read by mapping
+ * the file rather than parsing it.
+ */
+class ProjectionCache {
+    public:
+        //-- cache files are kept in dir, which must already exist; data is the input data
+        //-- the relation tables are projections of
+        ProjectionCache(const char *dir, Table *data);
+        ~ProjectionCache();
+
+        //-- a table for rel mapped from its cache file, or NULL if there is none
+        Table *load(Relation *rel);
+
+        //-- write rel's table to its cache file. Failures only print a warning, as the
+        //-- cache is just an optimization.
+        void save(Relation *rel, Table *table);
+
+        long long getHits() {
+            return hits;
+        }
+
+    private:
+        void makePath(Relation *rel, char *path, int size);
+
+        char *dir;
+        int keysize;
+        unsigned long long fingerprint; // hash of the keys and values of the input data
+        long long hits;
+        bool warned;
+};
+
+#endif
@@ -15,9 +15,15 @@
  * the cache matches on the mask for the relation, which uniquely identifies the
  * set of variables in the relation.
  * There must be a separate relation cache for each different problem instance.
+ * The cache itself may be used from several threads at once (see CacheTable); the
+ * relations it holds are not locked.
  *
  */
-#define RELCACHE_HASHSIZE 1001
+#include "CacheTable.h"
+#include <mutex>
+#include <set>
+#include <vector>
+
 class RelCache {
     public:
 	//-- construct an empty relation cache
@@ -35,14 +41,55 @@ class RelCache {
 	//-- exists, an error is returned.
 	bool addRelation(class Relation *rel);
 
+	//-- findOrAddRelation - put a new relation in the cache, unless a matching one is
+	//-- already there, as one step. Returns the cached relation; if that isn't rel,
+	//-- rel wasn't added.
+	class Relation *findOrAddRelation(class Relation *rel);
+
 	//-- findRelation - find a relation in the cache.  Null is returned if the given
 	//-- relation doesn't exist.
 	class Relation *findRelation(const char *name);
 
+	//-- addTable - record that the relation now has a projection table, so it can be found
+	//-- by findSmallestSuperset. Tables deleted later are dropped from the index as met.
+	void addTable(class Relation *rel);
+
+	//-- findSmallestSuperset - of the relations recorded by addTable which still have a table
+	//-- and contain the given relation (but aren't it), the one with the fewest tuples, or NULL.
+	//-- State-based relations are never returned.
+	class Relation *findSmallestSuperset(class Relation *rel);
+
+	//-- touch - record a use of the relation's table, for least-recently-used eviction.
+	//-- Returns the use stamp given to it.
+	unsigned long long touch(class Relation *rel);
+	unsigned long long getUseClock();
+
+	//-- trimTables - while the projection tables in the cache take more than budget bytes,
+	//-- delete the least recently used. The relations themselves stay in the cache, so
+	//-- a released table is simply projected again when next needed. Tables used after
+	//-- the stamp since (see getUseClock), and the table keep (the input data, held by the top
+	//-- relation), are never released. Returns the number of tables released.
+	long trimTables(long long budget, unsigned long long since, class Table *keep);
+
+	//-- reclaim - free the slot arrays the cache has outgrown (see CacheTable::reclaim).
+	//-- No other thread may be using the cache.
+	void reclaim();
+
 	void dump();
 
     private:
-	class Relation **hash;
+	//-- orders a (tuple count, relation) pair by count, then by name
+	struct TableOrder {
+	    bool operator()(const std::pair<long long, class Relation*> &a,
+		    const std::pair<long long, class Relation*> &b) const;
+	};
+	typedef std::set<std::pair<long long, class Relation*>, TableOrder> TableSet;
+
+	CacheTable<class Relation> relations;
+	unsigned long long useClock;
+	std::mutex lock; // for the use clock and stamps
+	std::vector<TableSet> tables; // relations with tables, by variable count
+	std::mutex tableLock; // for tables
 };
 
 #endif
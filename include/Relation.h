@@ -103,12 +103,12 @@ class Relation {
         void sort();
         static void sort(int *vars, int varcount, int *states = nullptr);
 
-        // set, get hash chain linkages
-        Relation *getHashNext() {
-            return hashNext;
+        // set, get the last use of the table, for least-recently-used eviction (see RelCache)
+        unsigned long long getUseStamp() {
+            return useStamp;
         }
-        void setHashNext(Relation *next) {
-            hashNext = next;
+        void setUseStamp(unsigned long long stamp) {
+            useStamp = stamp;
         }
 
         // get the attribute list for the relation
@@ -140,7 +140,7 @@ class Relation {
         int maxVarCount; // size of vars array
         class Table *table;
         class StateConstraint *stateConstraints; // state constraints
-        Relation *hashNext; // linkage for storing relations in a hash table
+        unsigned long long useStamp; // RelCache use clock at the last use of the table
         KeySegment *mask; // mask has zero for variables in this rel, 1's elsewhere
         class AttributeList *attributeList;
         char *printName;
@@ -32,11 +32,19 @@ class StateConstraint {
         // get the key size for this constraint table
         int getKeySize();
 
+        // find a constraint equal to the given key, returning its index or -1. This is
+        // a hash probe, so testing every tuple of a table against the constraints is linear.
+        long indexOf(KeySegment *key);
+
     private:
+        void indexRebuild(long capacity);
+
         KeySegment *constraints;
         long constraintCount;
         long maxConstraintCount;
         int keysize;
+        long *index; // open-addressing slots holding constraint indices, -1 if empty
+        long indexCapacity; // number of slots in index (a power of 2)
 };
 
 #endif
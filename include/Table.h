@@ -18,6 +18,12 @@
  * Table - defines a data table, which is a collection of tuples. The tuples are stored
  * in a contiguous table.  Since tuples are variable sized, the Table object stores the
  * size information for the tuple storage.
+ *
+ * In the interleaved layout (the default) each key is followed by its value. In the
+ * columnar layout the keys are in one array and the values in another, so passes over
+ * just the values, or just the keys (as in indexOf), touch only the memory they need.
+ * A table keeps the layout it was created with, except that a mapped table (see
+ * attachMapped) is always interleaved, as the files are.
  */
 
 class Relation;
@@ -38,6 +44,11 @@ class Table {
 
         //-- key and value access functions
         double getValue(long long index);
+        void copyValues(long long start, long long count, double *dest); // values into an array
+        //-- the values as a plain array, if the layout is columnar; otherwise NULL
+        ocTupleValue *getValueColumn() {
+            return layout == TableLayout::Columnar ? values : NULL;
+        }
         void setValue(long long index, double value);
         KeySegment *getKey(long long index);
         void copyKey(long long index, KeySegment *key);
@@ -52,9 +63,34 @@ class Table {
             return keysize;
         }
 
+        TableLayout getLayout() {
+            return layout;
+        }
+        //-- the layout of tables created from now on (the table-layout option)
+        static void setDefaultLayout(TableLayout layout);
+        static TableLayout getDefaultLayout();
+
         void sort(); // sort tuples by key
         void reset(int keysize); // reset table to empty, but reuse the storage
 
+        //-- hash-indexed mode. While the index is active, addTuple and sumTuple append in
+        //-- constant time, indexOf(key) is answered from an open-addressing hash, and tuples
+        //-- stay in insertion order. finalize() sorts once and drops the index; any operation
+        //-- which needs sorted order (sort, indexOf with matchOnly false) finalizes implicitly.
+        void beginHashed();
+        void finalize();
+        bool isHashed() {
+            return hashIndex != NULL;
+        }
+
+        //-- bulk-load support: after appending tuples with addTuple in any order, sort them
+        //-- with a radix sort over the key bits and merge duplicate keys in one linear pass.
+        void sortAndMerge();
+
+        //-- replace the contents with the tuples of from, each key masked (see Key::buildMask),
+        //-- and tuples with equal masked keys summed. The result is sorted.
+        void groupBy(Table *from, KeySegment *mask);
+
         // dump debug output
         void dump(bool detail = false);
 
@@ -70,12 +106,56 @@ class Table {
         // Returns the lowest value in the table.
         double getLowestValue();
 
+        //-- use count tuples mapped from a file (see ProjectionCache) as the table's storage,
+        //-- in place of its own. The mapping may be read-only: the tuples are copied to
+        //-- ordinary storage before the table is first changed, and the mapping (base,
+        //-- length) is unmapped when it is no longer used.
+        void attachMapped(void *base, size_t length, void *tuples, long long count);
+
+        //-- for a mapped table, the same tuples normalized, also in the mapping, with the
+        //-- total normalize() divides by. Until the table is changed, normalize() switches
+        //-- to these and returns sum, without writing to the mapping.
+        void attachNormalized(void *tuples, double sum);
+        bool isMapped() {
+            return mapBase != NULL;
+        }
+
     private:
-        void* data; // storage for all keys and values
+        void ownStorage();
+        void reserve(long long count);
+        KeySegment *keyAt(long long index) const;
+        ocTupleValue *valueAt(long long index) const;
+        template <typename F> void eachValue(F action);
+        void packTuples(char *dest);
+        void unpackTuples(char *src);
+
+        long long hashFind(KeySegment *key);
+        void hashInsert(long long index);
+
+        //-- the key loops of indexOf, hashFind, sortAndMerge and groupBy, for keys of N
+        //-- segments (see Key::FixedKeys)
+        template <int N> long long searchKeys(KeySegment *key, bool matchOnly);
+        template <int N> long long hashFindKeys(KeySegment *key);
+        template <int N> void mergeEqualKeys();
+        template <int N> void groupKeys(char *scratch, char *spare, Table *from, KeySegment *mask);
+        void hashRebuild(long long capacity);
+        void hashDrop();
+
+        void* data; // storage for all keys and values (only keys, if columnar)
+        ocTupleValue *values; // storage for the values if columnar, otherwise NULL
+        TableLayout layout;
         int keysize; // number of key segments in the key for each tuple
         long long tupleCount; // number of tuples in the tuple array
         long long maxTupleCount; // the total size of the data member, in terms of tuples
         TableType type; // one of INFO_TYPE, SET_TYPE
+        long long *hashIndex; // open-addressing slots holding tuple indices, or NULL if not hashed
+        long long hashCapacity; // number of slots in hashIndex (a power of 2)
+        void *mapBase; // file mapping holding data, or NULL if data is our own
+        size_t mapLength;
+        void *normalTuples; // see attachNormalized, or NULL
+        double normalSum;
+
+        static TableLayout defaultLayout;
 };
 
 template <typename F>
@@ -8,14 +8,15 @@
 #ifndef ___Types
 #define ___Types
 
-//-- typedef for constructing data keys - defined as a 32-bit type. A key consists
+//-- typedef for constructing data keys - the native unsigned long (64 bits on LP64). A key consists
 //-- of an array of key segments.  Variable values are packed together into the key
-//-- but don't cross segment boundaries. For example, 16 3-state variables can be
-//-- packed into one key segment.
+//-- but don't cross segment boundaries. For example, 3-state variables take 2 bits each,
+//-- so 32 of them can be packed into one 64-bit key segment.
 
 typedef unsigned long KeySegment;
 typedef double ocTupleValue;
 enum class Direction { Ascending, Descending };
 enum class TableType { InformationTheoretic, SetTheoretic };
+enum class TableLayout { Interleaved, Columnar };
 
 #endif
@@ -21,9 +21,17 @@ class Variable { // internal use only - see VariableList
         KeySegment mask; // a bitmask of 1's in the bit positions for this variable
         char name[MAXNAMELEN + 1]; // long name of variable (max 32 chars)
         char abbrev[MAXABBREVLEN + 1]; // abbreviated name for variable
-        char* valmap[MAXCARDINALITY]; // maps input file values to nominal values
+        char** valmap; // maps input file values to nominal values (one entry per key value)
+        int valueCount; // number of values in valmap so far
+        int *valueSlots; // open-addressing hash of the valmap strings; slots hold indices, or -1
+        int valueSlotCount; // number of slots in valueSlots (a power of 2)
         bool rebin; //is rebinning required for this variable
-        char * oldnew[2][MAXCARDINALITY];
+        char ** oldnew[2]; // rebinning map: old values, and the new values for them, up to a NULL new value
+        int oldnewSize; // number of entries allocated in each row of oldnew
+        int *rebinSlots; // compiled rebinning map: open-addressing hash of old values; slots hold entries of oldnew, or -1
+        int rebinSlotCount; // number of slots in rebinSlots (a power of 2), or 0 if not compiled
+        int rebinDefault; // the rule for values not in rebinSlots: the "*" entry, DISCARD, or REBIN_KEEP
+        int *rebinIndices; // for each entry of oldnew, the value index of its new value, or -1 if not yet seen
         int old_card;
         char *exclude;
 };
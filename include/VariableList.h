@@ -87,6 +87,25 @@ class VariableList {
         //get the new rebinning value for an old one
         int getNewValue(int, char*, char*);
 
+        //-- make room for at least count entries in each row of a variable's rebinning map
+        void growRebinMap(int varindex, int count);
+
+        //-- compile a variable's rebinning map, or its exclude value, into a hash from old
+        //-- value to rule, so getRebinRule costs one probe. Called once the map is complete.
+        void compileRebin(int varindex);
+
+        //-- the rule for a (raw) value of a rebinned or excluded variable: an entry of its
+        //-- rebinning map, DISCARD if lines with the value are dropped, or REBIN_KEEP if the
+        //-- value is used as it is
+        int getRebinRule(int varindex, const char *value);
+
+        //-- the new value of a rebinning rule, and its value index (added to the value map
+        //-- the first time it is asked for, as getVarValueIndex does)
+        const char *getRebinValue(int varindex, int rule) {
+            return vars[varindex].oldnew[NEW_ROW][rule];
+        }
+        int getRebinValueIndex(int varindex, int rule);
+
     private:
         Variable *vars;
         int varCount; // number of variables defined so far
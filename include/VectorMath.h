@@ -0,0 +1,40 @@
+/*
+ * Copyright © 1990 The Portland State University OCCAM Project Team
+ * [This program is licensed under the GPL version 3 or later.]
+ * Please see the file LICENSE in the source
+ * distribution of this software for license terms.
+ */
+
+#ifndef ___VectorMath
+#define ___VectorMath
+
+/**
+ * VectorMath - the p log p sums behind ocEntropy and ocTransmission, over plain arrays
+ * of values, using SIMD instructions. AVX2 is used when the processor has it, SSE2
+ * otherwise; the choice is made at run time, on first use.
+ *
+ * The natural log is computed in vector registers with the fdlibm method (reduce to
+ * a mantissa near 1, then a rational approximation), and is within 1 ulp of libm's log
+ * (run "entropybench" to check this on a given machine). Both instruction sets do the
+ * same operations in the same order, into four partial sums combined the same way, so
+ * they give identical results; these differ from a plain scalar loop only by rounding.
+ */
+
+//-- sum of p[i] ln p[i] over the entries with p[i] > PROB_MIN
+double ocSumPLogP(const double *p, long long n);
+
+//-- sum of p[i] ln (p[i] / q[i]) over the entries with p[i] and q[i] both > PROB_MIN.
+//-- The ratios are assumed to be finite, as they are for probabilities.
+double ocSumPLogPQ(const double *p, const double *q, long long n);
+
+//-- natural log of each of n positive, finite, normal values
+void ocLogArray(const double *x, double *out, long long n);
+
+//-- the instruction set in use ("avx2" or "sse2")
+const char *ocVectorISA();
+
+//-- use the given instruction set rather than the best available, for testing; returns
+//-- false if it is unknown or the processor lacks it
+bool ocUseVectorISA(const char *name);
+
+#endif
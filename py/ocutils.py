@@ -248,6 +248,9 @@ class ocUtils:
     def processModel(self, level, newModelsHeap, model):
         addCount = 0
         generatedModels = self.__manager.searchOneLevel(model)
+        # project the new models' relations together, so each is made once (and in parallel,
+        # with the projection-threads option) before the models are evaluated
+        self.__manager.makeProjections([m for m in generatedModels if m.get("processed") <= 0.0])
         for newModel in generatedModels:
             if newModel.get("processed") <= 0.0 :
                 newModel.processed = 1.0
@@ -298,6 +301,7 @@ class ocUtils:
         if clear_cache_flag:
             for item in newModelsHeap:
                 self.__manager.deleteModelFromCache(item[1])
+            self.__manager.reclaimCaches()
         return bestModels
 
 